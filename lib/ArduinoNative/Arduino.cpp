@@ -0,0 +1,36 @@
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::atomic<bool> clockPinned(false);
+static std::atomic<uint64_t> pinnedMicros(0);
+
+unsigned long millis() {
+  if (clockPinned) {
+    return pinnedMicros / 1000;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+  if (clockPinned) {
+    return pinnedMicros;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void setNativeClock(uint64_t micros) {
+  pinnedMicros = micros;
+  clockPinned = true;
+}
+
+void releaseNativeClock() {
+  clockPinned = false;
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
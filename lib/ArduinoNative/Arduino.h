@@ -0,0 +1,23 @@
+#ifndef ARDUINO_NATIVE_H
+#define ARDUINO_NATIVE_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// Host only: pins millis() and micros() to a given time, e.g. the timestamps
+// of a replayed capture, until releaseNativeClock()
+void setNativeClock(uint64_t micros);
+void releaseNativeClock();
+
+#endif // ARDUINO_NATIVE_H
@@ -0,0 +1,52 @@
+#include "MemoryStream.h"
+
+MemoryStream::MemoryStream() : _position(0) {
+}
+
+void MemoryStream::feed(const uint8_t* data, size_t length) {
+  if (_position == _input.size()) {
+    _input.clear();
+    _position = 0;
+  }
+  _input.insert(_input.end(), data, data + length);
+}
+
+const std::vector<uint8_t>& MemoryStream::output() const {
+  return _output;
+}
+
+void MemoryStream::clearOutput() {
+  _output.clear();
+}
+
+int MemoryStream::available() {
+  return _input.size() - _position;
+}
+
+int MemoryStream::read() {
+  if (_position >= _input.size()) {
+    return -1;
+  }
+  return _input[_position++];
+}
+
+int MemoryStream::peek() {
+  if (_position >= _input.size()) {
+    return -1;
+  }
+  return _input[_position];
+}
+
+size_t MemoryStream::write(uint8_t value) {
+  _output.push_back(value);
+  return 1;
+}
+
+size_t MemoryStream::write(const uint8_t* buffer, size_t size) {
+  _output.insert(_output.end(), buffer, buffer + size);
+  return size;
+}
+
+int MemoryStream::availableForWrite() {
+  return 4096;
+}
@@ -0,0 +1,31 @@
+#ifndef ARDUINO_NATIVE_MEMORY_STREAM_H
+#define ARDUINO_NATIVE_MEMORY_STREAM_H
+
+#include <vector>
+#include "Stream.h"
+
+// In-memory Stream. Bytes passed to feed() are returned by read(), and
+// everything written is collected in output().
+class MemoryStream : public Stream {
+public:
+  MemoryStream();
+
+  void feed(const uint8_t* data, size_t length);
+  const std::vector<uint8_t>& output() const;
+  void clearOutput();
+
+  int available() override;
+  int read() override;
+  int peek() override;
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int availableForWrite() override;
+
+private:
+  std::vector<uint8_t> _input;
+  size_t _position;
+  std::vector<uint8_t> _output;
+};
+
+#endif // ARDUINO_NATIVE_MEMORY_STREAM_H
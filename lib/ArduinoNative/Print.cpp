@@ -0,0 +1,126 @@
+#include "Print.h"
+
+#include <stdio.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size-- > 0) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+int Print::availableForWrite() {
+  return 0;
+}
+
+void Print::flush() {
+}
+
+size_t Print::write(const char* value) {
+  if (value == nullptr) {
+    return 0;
+  }
+  return write(reinterpret_cast<const uint8_t*>(value), strlen(value));
+}
+
+size_t Print::print(const char* value) {
+  return write(value);
+}
+
+size_t Print::print(const String& value) {
+  return write(value.c_str());
+}
+
+size_t Print::print(char value) {
+  return write(static_cast<uint8_t>(value));
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return printNumber(value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return printSigned(value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return printNumber(value, base);
+}
+
+size_t Print::print(long value, int base) {
+  return printSigned(value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return write(buffer);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::println(const char* value) {
+  return print(value) + println();
+}
+
+size_t Print::println(const String& value) {
+  return print(value) + println();
+}
+
+size_t Print::println(char value) {
+  return print(value) + println();
+}
+
+size_t Print::println(unsigned char value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(int value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits) {
+  return print(value, digits) + println();
+}
+
+size_t Print::printNumber(unsigned long value, int base) {
+  if (base < 2 || base > 16) {
+    base = DEC;
+  }
+
+  char buffer[8 * sizeof(long) + 1];
+  char* cursor = buffer + sizeof(buffer) - 1;
+  *cursor = '\0';
+  do {
+    *--cursor = "0123456789ABCDEF"[value % base];
+    value /= base;
+  } while (value > 0);
+  return write(cursor);
+}
+
+size_t Print::printSigned(long value, int base) {
+  if (base == DEC && value < 0) {
+    return print('-') + printNumber(-static_cast<unsigned long>(value), base);
+  }
+  return printNumber(value, base);
+}
@@ -0,0 +1,50 @@
+#ifndef ARDUINO_NATIVE_PRINT_H
+#define ARDUINO_NATIVE_PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  virtual int availableForWrite();
+  virtual void flush();
+
+  size_t write(const char* value);
+
+  size_t print(const char* value);
+  size_t print(const String& value);
+  size_t print(char value);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println();
+  size_t println(const char* value);
+  size_t println(const String& value);
+  size_t println(char value);
+  size_t println(unsigned char value, int base = DEC);
+  size_t println(int value, int base = DEC);
+  size_t println(unsigned int value, int base = DEC);
+  size_t println(long value, int base = DEC);
+  size_t println(unsigned long value, int base = DEC);
+  size_t println(double value, int digits = 2);
+
+private:
+  size_t printNumber(unsigned long value, int base);
+  size_t printSigned(long value, int base);
+};
+
+#endif // ARDUINO_NATIVE_PRINT_H
@@ -0,0 +1,13 @@
+#include "Stream.h"
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length && available() > 0) {
+    int value = read();
+    if (value < 0) {
+      break;
+    }
+    buffer[count++] = value;
+  }
+  return count;
+}
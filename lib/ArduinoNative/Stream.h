@@ -0,0 +1,15 @@
+#ifndef ARDUINO_NATIVE_STREAM_H
+#define ARDUINO_NATIVE_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  size_t readBytes(uint8_t* buffer, size_t length);
+};
+
+#endif // ARDUINO_NATIVE_STREAM_H
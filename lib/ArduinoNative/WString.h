@@ -0,0 +1,66 @@
+#ifndef ARDUINO_NATIVE_WSTRING_H
+#define ARDUINO_NATIVE_WSTRING_H
+
+#include <stddef.h>
+#include <string>
+
+// Subset of the Arduino String API used by Print
+class String {
+public:
+  String(const char* value = "") : _value(value != nullptr ? value : "") {}
+  String(const std::string& value) : _value(value) {}
+
+  String& operator=(const char* value) {
+    _value = value != nullptr ? value : "";
+    return *this;
+  }
+
+  String& operator+=(char value) {
+    _value += value;
+    return *this;
+  }
+
+  String& operator+=(const char* value) {
+    concat(value);
+    return *this;
+  }
+
+  bool operator==(const String& other) const {
+    return _value == other._value;
+  }
+
+  bool operator!=(const String& other) const {
+    return _value != other._value;
+  }
+
+  bool concat(const char* value) {
+    if (value == nullptr) {
+      return false;
+    }
+    _value += value;
+    return true;
+  }
+
+  bool concat(char value) {
+    _value += value;
+    return true;
+  }
+
+  bool reserve(size_t size) {
+    _value.reserve(size);
+    return true;
+  }
+
+  const char* c_str() const {
+    return _value.c_str();
+  }
+
+  size_t length() const {
+    return _value.length();
+  }
+
+private:
+  std::string _value;
+};
+
+#endif // ARDUINO_NATIVE_WSTRING_H
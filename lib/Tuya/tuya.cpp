@@ -1,13 +1,18 @@
 #include "tuya.h"
+#include "tuya_static_frame.h"
+
+static_assert(TUYA_MAX_TIMERS <= 8, "internal timers are tracked in a uint8_t mask");
 
 Tuya::Tuya()
-  : _delay(250), _debug(false), _pSerial(nullptr), _pDebugSerial(nullptr), _lastHeartbeats(0) {
+  : _id(TUYA_NO_DEVICE_ID), _handshakeInterval(250), _pSerial(nullptr), _pModuleSerial(nullptr), _passive(false),
+    _flushOnSend(false), _internalTimers(0),
+    _requests(requestSender, this), _heartbeatTimer(TUYA_INVALID_TIMER), _pLog(&tuyaDefaultLog()), _logAutoFlush(true),
+    _stats(), _beganAt(0), _lastFrameAt(0), _frameSeen(false), _ready(false), _reportsSinceQuery(0), _pCapture(nullptr),
+    _pStore(nullptr), _snapshotTimer(TUYA_INVALID_TIMER), _snapshotCrc(0), _snapshotCrcValid(false),
+    _stateChanged(false), _readingsChanged(false), _snapshotAt(0), _warm(false), _onResetWiFiPairMode(nullptr),
+    _onResetWiFiPairModeDevice(nullptr), _onResetWiFiPairModeContext(nullptr) {
   _state = {
-    .information = {
-      .productId = "",
-      .version = "",
-      .operationMode = 0,
-    },
+    .information = {},
     .networkStatus = WIFI_NOT_CONNECTED,
     .heartbeats = false,
     .productInfo = false,
@@ -18,6 +23,38 @@ Tuya::Tuya()
 
 void Tuya::begin(Stream* pSerial) {
   _pSerial = pSerial;
+  _pModuleSerial = nullptr;
+  _passive = false;
+  _ready = false;
+  _beganAt = millis();
+
+  cancelInternal(_heartbeatTimer);
+  _requests.clear();
+  _heartbeatTimer = everyInternal(1000, heartbeatTask, this);
+  _scheduler.trigger(_heartbeatTimer);
+  warmStart();
+}
+
+// Listens to an existing module and MCU instead of replacing the module:
+// pMcuSerial receives the MCU's TX line and pModuleSerial the module's. MCU
+// frames go through the usual handlers, nothing is ever transmitted, and each
+// request is paired with its response for getRoundTripStats().
+void Tuya::beginPassive(Stream* pMcuSerial, Stream* pModuleSerial) {
+  _pSerial = pMcuSerial;
+  _pModuleSerial = pModuleSerial;
+  _passive = true;
+  _ready = false;
+  _beganAt = millis();
+
+  cancelInternal(_heartbeatTimer);
+  _heartbeatTimer = TUYA_INVALID_TIMER;
+  _requests.clear();
+  _roundTrips.reset();
+  warmStart();
+}
+
+bool Tuya::isPassive() const {
+  return _passive;
 }
 
 void Tuya::loop() {
@@ -25,43 +62,182 @@ void Tuya::loop() {
     return;
   }
 
-  intervalHeartbeats = _state.heartbeats ? 15000 : 1000;
-  if (millis() - _lastHeartbeats > intervalHeartbeats) {
-    sendHeartbeats();
-    _lastHeartbeats = millis();
+  uint32_t loopStart = micros();
+  if (_passive) {
+    readPassive(loopStart);
+  } else {
+    uint32_t readStart = loopStart;
+    TuyaFrameView frame;
+    TuyaErrorTransmission result;
+    while ((result = listeningMessage(_pSerial, _parser, _stats.bytesIn, loopStart, frame)) != ERROR_NO_DATA) {
+      countResult(result);
+      if (result == ERROR_NONE) {
+        _stats.parseLatency.add(micros() - readStart);
+        processFrame(frame);
+      }
+      readStart = micros();
+    }
   }
 
-  if (_state.heartbeats && !_state.productInfo) {
-    queryProductInfo();
+  uint32_t now = millis();
+  _scheduler.run(now);
+  _requests.run(now);
+  transmitFrames();
+
+  // Idle point of the pass, format a few deferred log records
+  if (_logAutoFlush) {
+    _pLog->flush(TUYA_LOG_FLUSH_RECORDS);
   }
 
-  if (_state.heartbeats && !_state.workingMode) {
-    queryWorkingMode();
+  _stats.loops++;
+  _stats.loopDuration.add(micros() - loopStart);
+}
+
+void Tuya::feed(const uint8_t* bytes, size_t length) {
+  uint32_t now = micros();
+  _stats.bytesIn += length;
+  for (size_t i = 0; i < length; i++) {
+    TuyaErrorTransmission result = _parser.push(bytes[i], now);
+    while (result != ERROR_NO_DATA) {
+      countResult(result);
+      if (result == ERROR_NONE) {
+        processFrame(_parser.view());
+      }
+      result = _parser.poll();
+    }
   }
+}
 
-  TuyaFrame frame;
-  if (listeningMessage(frame) == ERROR_NONE) {
-    decodeFrame(frame);
+// How long loop() may sleep before a timer or retry is due, for hosts that
+// wait on the serial port instead of polling
+uint32_t Tuya::timeUntilNext() {
+  if (_txQueue.size() > 0) {
+    return 0;
   }
+  uint32_t now = millis();
+  uint32_t timers = _scheduler.timeUntilNext(now);
+  uint32_t requests = _requests.timeUntilNext(now);
+  return timers < requests ? timers : requests;
+}
 
-  _state.initialized = _state.heartbeats && _state.productInfo && _state.workingMode;
+void Tuya::debug(Stream& stream, bool enable) {
+  _pLog->setOutput(enable ? &stream : nullptr);
+}
 
-  delay(_delay);
+// Turn off when a separate low-priority task calls logger().flush()
+void Tuya::setLogAutoFlush(bool enable) {
+  _logAutoFlush = enable;
 }
 
-void Tuya::debug(Stream& stream, bool enable) {
-  _debug = enable;
-  _pDebugSerial = _debug ? &stream : nullptr;
+// Records of this device are tagged with the id in a shared log
+void Tuya::setId(uint8_t id) {
+  _id = id;
+}
+
+uint8_t Tuya::getId() const {
+  return _id;
+}
+
+// Devices log into tuyaDefaultLog() unless given their own. nullptr goes
+// back to the default.
+void Tuya::setLog(TuyaLog* log) {
+  _pLog = log != nullptr ? log : &tuyaDefaultLog();
+}
+
+TuyaLog& Tuya::logger() {
+  return *_pLog;
+}
+
+void Tuya::capture(TuyaCaptureWriter* writer) {
+  _pCapture = writer;
 }
 
-void Tuya::setDelay(uint32_t delay) {
-  _delay = delay;
+// Snapshots product info, working mode and the subclass state into store,
+// at most once per interval and only when something changed. Call before
+// begin(): a valid snapshot then makes the device initialized right away
+// while the handshake confirms it in the background.
+void Tuya::persist(TuyaStateStore* store, uint32_t interval) {
+  _pStore = store;
+  cancelInternal(_snapshotTimer);
+  _snapshotTimer = TUYA_INVALID_TIMER;
+  if (store != nullptr) {
+    _snapshotTimer = everyInternal(interval, snapshotTask, this);
+  }
+}
+
+// Writes the snapshot now if it differs from the stored one, e.g. before a
+// planned restart. Nothing is written before the handshake has completed.
+bool Tuya::saveSnapshot() {
+  if (_pStore == nullptr || !_state.productInfo || !_state.workingMode) {
+    return false;
+  }
+
+  uint8_t section[TUYA_SNAPSHOT_SIZE];
+  TuyaSnapshotWriter sectionWriter(section, UINT8_MAX < sizeof(section) ? UINT8_MAX : sizeof(section));
+  if (!saveState(sectionWriter) || sectionWriter.overflowed()) {
+    return false;
+  }
+
+  uint8_t blob[TUYA_SNAPSHOT_SIZE];
+  TuyaSnapshotWriter writer(blob, sizeof(blob));
+  writer.putU8('T');
+  writer.putU8('S');
+  writer.putU8(TUYA_SNAPSHOT_VERSION);
+  writer.putU16(0);
+  writer.putU16(_state.information.operationMode);
+  writer.putString(_state.information.productId);
+  writer.putString(_state.information.version);
+  writer.putU8(sectionWriter.length());
+  writer.putBytes(section, sectionWriter.length());
+
+  uint16_t payload = writer.length() - (TUYA_SNAPSHOT_HEADER_SIZE);
+  blob[3] = payload & 0xFF;
+  blob[4] = payload >> 8;
+  uint16_t crc = tuyaCrc16(blob, writer.length());
+  writer.putU16(crc);
+  if (writer.overflowed()) {
+    return false;
+  }
+
+  _stateChanged = false;
+  _readingsChanged = false;
+  _snapshotAt = millis();
+  if (_snapshotCrcValid && crc == _snapshotCrc) {
+    return true;
+  }
+  if (!_pStore->save(blob, writer.length())) {
+    _pLog->warn(_id, "Snapshot write failed");
+    return false;
+  }
+  _snapshotCrc = crc;
+  _snapshotCrcValid = true;
+  return true;
+}
+
+void Tuya::setFlushOnSend(bool enable) {
+  _flushOnSend = enable;
+}
+
+// Initial reply timeout of the handshake queries, doubled on every retry
+void Tuya::setHandshakeInterval(uint32_t interval) {
+  _handshakeInterval = interval;
 }
 
 bool Tuya::isInitialized() const {
   return _state.initialized;
 }
 
+// Initialized and every DP the device cares about reported at least once.
+// Subclasses that know their DPs narrow this down.
+bool Tuya::isReady() const {
+  return _state.initialized;
+}
+
+// Initialized from a snapshot, the handshake has not confirmed it yet
+bool Tuya::isWarm() const {
+  return _warm;
+}
+
 TuyaNetworkStatus Tuya::getNetworkStatus() const {
   return _state.networkStatus;
 }
@@ -70,102 +246,307 @@ TuyaProductInformation Tuya::getProductInformation() const {
   return _state.information;
 }
 
+// Copy the returned struct to keep a snapshot
+const TuyaStats& Tuya::getStats() {
+  _stats.skippedBytes = _parser.skipped() + _moduleParser.skipped();
+  return _stats;
+}
+
+const TuyaRoundTripStats& Tuya::getRoundTripStats() const {
+  return _roundTrips.stats();
+}
+
+void Tuya::resetStats() {
+  uint32_t timeToInitialized = _stats.timeToInitialized;
+  uint32_t timeToReady = _stats.timeToReady;
+  _stats = {};
+  _stats.timeToInitialized = timeToInitialized;
+  _stats.timeToReady = timeToReady;
+  _parser.clearSkipped();
+  _moduleParser.clearSkipped();
+  _roundTrips.reset();
+}
+
 void Tuya::onResetWiFiPairMode(void (*callback)()) {
   _onResetWiFiPairMode = callback;
 }
 
-TuyaErrorTransmission Tuya::listeningMessage(TuyaFrame& frame) {
-  while (_pSerial->available()) {
-    frame.header[0] = _pSerial->read();
-    if (frame.header[0] == 0x55) {
-      frame.header[1] = _pSerial->read();
-      if (frame.header[1] == 0xAA) {
-        frame.version = _pSerial->read();
-        frame.command = _pSerial->read();
-        frame.length[0] = _pSerial->read();
-        frame.length[1] = _pSerial->read();
-        uint16_t dataLength = (frame.length[0] << 8) | frame.length[1];
-        if (dataLength > sizeof(frame.data)) {
-          _pSerial->flush();
-          return ERROR_OVERFLOW;
-        }
-        if (dataLength > 0) {
-          _pSerial->readBytes(frame.data, dataLength);
-        }
-        frame.checksum = _pSerial->read();
-        if (!validateChecksum(frame)) {
-          _pSerial->flush();
-          return ERROR_CHECKSUM;
-        }
-        _pSerial->flush();
-        return ERROR_NONE;
-      }
-    }
+void Tuya::onResetWiFiPairMode(void (*callback)(Tuya& device, void* context), void* context) {
+  _onResetWiFiPairModeDevice = callback;
+  _onResetWiFiPairModeContext = context;
+}
+
+int8_t Tuya::every(uint32_t interval, TuyaTimerCallback callback, void* context) {
+  return _scheduler.every(interval, callback, context);
+}
+
+int8_t Tuya::after(uint32_t delay, TuyaTimerCallback callback, void* context) {
+  return _scheduler.after(delay, callback, context);
+}
+
+// Timers the library runs for itself cannot be cancelled from outside
+void Tuya::cancel(int8_t timer) {
+  if (timer < 0 || timer >= TUYA_MAX_TIMERS || (_internalTimers & (1 << timer)) != 0) {
+    return;
   }
-  return ERROR_NO_DATA;
+  _scheduler.cancel(timer);
 }
 
-bool Tuya::validateChecksum(const TuyaFrame& frame) const {
-  uint16_t sum = frame.header[0] + frame.header[1] + frame.version + frame.command + frame.length[0] + frame.length[1];
-  for (uint16_t i = 0; i < ((frame.length[0] << 8) | frame.length[1]); i++) {
-    sum += frame.data[i];
+int8_t Tuya::everyInternal(uint32_t interval, TuyaTimerCallback callback, void* context) {
+  int8_t timer = _scheduler.every(interval, callback, context);
+  if (timer != TUYA_INVALID_TIMER) {
+    _internalTimers |= 1 << timer;
   }
-  return (sum % 256) == frame.checksum;
+  return timer;
 }
 
-uint8_t Tuya::generateChecksum(const TuyaFrame& frame) const {
-  uint16_t sum = frame.header[0] + frame.header[1] + frame.version + frame.command + frame.length[0] + frame.length[1];
-  for (uint16_t i = 0; i < ((frame.length[0] << 8) | frame.length[1]); i++) {
-    sum += frame.data[i];
+void Tuya::cancelInternal(int8_t timer) {
+  if (timer < 0 || timer >= TUYA_MAX_TIMERS) {
+    return;
+  }
+  _internalTimers &= ~(1 << timer);
+  _scheduler.cancel(timer);
+}
+
+TuyaErrorTransmission Tuya::listeningMessage(Stream* pSerial, TuyaFrameParser& parser, uint32_t& bytes,
+  uint32_t timestamp, TuyaFrameView& frame) {
+  TuyaErrorTransmission result = parser.poll();
+  while (result == ERROR_NO_DATA && pSerial->available() > 0) {
+    int byte = pSerial->read();
+    if (byte < 0) {
+      break;
+    }
+    bytes++;
+    result = parser.push(byte, timestamp);
+  }
+
+  if (result == ERROR_NONE) {
+    frame = parser.view();
+  }
+  return result;
+}
+
+// Reads up to the next complete frame of one line, counting bad frames on
+// the way. The frame stays valid until the parser is read again.
+bool Tuya::readFrame(Stream* pSerial, TuyaFrameParser& parser, uint32_t& bytes, uint32_t timestamp,
+  TuyaFrameView& frame) {
+  TuyaErrorTransmission result;
+  while ((result = listeningMessage(pSerial, parser, bytes, timestamp, frame)) != ERROR_NO_DATA) {
+    countResult(result);
+    if (result == ERROR_NONE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Bytes of both lines are stamped with the time this pass found them, so a
+// frame's timestamp bounds its arrival regardless of which UART is drained
+// first. The oldest pending frame of either line is handled next; frames
+// found in the same pass put a request before a response it may have drawn.
+void Tuya::readPassive(uint32_t timestamp) {
+  TuyaFrameView mcuFrame;
+  TuyaFrameView moduleFrame;
+  bool mcu = false;
+  bool module = false;
+  while (true) {
+    if (!mcu) {
+      mcu = readFrame(_pSerial, _parser, _stats.bytesIn, timestamp, mcuFrame);
+    }
+    if (!module && _pModuleSerial != nullptr) {
+      module = readFrame(_pModuleSerial, _moduleParser, _stats.bytesOut, timestamp, moduleFrame);
+    }
+    if (!mcu && !module) {
+      return;
+    }
+
+    bool moduleFirst = !mcu;
+    if (mcu && module) {
+      int32_t order = (int32_t)(moduleFrame.timestamp - mcuFrame.timestamp);
+      moduleFirst = order < 0 || (order == 0 &&
+        (_roundTrips.isRequest(MODULE, moduleFrame.command) || !_roundTrips.isRequest(MCU, mcuFrame.command)));
+    }
+    if (moduleFirst) {
+      processModuleFrame(moduleFrame);
+      module = false;
+    } else {
+      processFrame(mcuFrame);
+      mcu = false;
+    }
   }
-  return (sum % 256);
 }
 
-TuyaFrame Tuya::generateFrame(TuyaDeviceType version, TuyaCommandType command, uint8_t* data, uint16_t dataLength) const {
-  TuyaFrame frame;
-  frame.header[0] = 0x55;
-  frame.header[1] = 0xAA;
-  frame.version = version;
-  frame.command = command;
-  frame.length[0] = (dataLength >> 8) & 0xFF;
-  frame.length[1] = dataLength & 0xFF;
+TuyaFrameBuffer* Tuya::generateFrame(TuyaDeviceType version, TuyaCommandType command, const uint8_t* data, uint16_t dataLength) {
+  if (TUYA_HEADER_SIZE + dataLength + 1 > TUYA_FRAME_BUFFER_SIZE) {
+    return nullptr;
+  }
+
+  TuyaFrameBuffer* buffer = acquireFrame();
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+
+  buffer->bytes[0] = 0x55;
+  buffer->bytes[1] = 0xAA;
+  buffer->bytes[2] = version;
+  buffer->bytes[3] = command;
+  buffer->bytes[4] = (dataLength >> 8) & 0xFF;
+  buffer->bytes[5] = dataLength & 0xFF;
   if (dataLength > 0) {
-    memcpy(frame.data, data, dataLength);
-  }
-  frame.checksum = generateChecksum(frame);
-  return frame;
-}
-
-TuyaFrame Tuya::generateFrame(TuyaDeviceType version, TuyaCommandType command) const {
-  TuyaFrame frame;
-  frame.header[0] = 0x55;
-  frame.header[1] = 0xAA;
-  frame.version = version;
-  frame.command = command;
-  frame.length[0] = 0x00;
-  frame.length[1] = 0x00;
-  frame.checksum = generateChecksum(frame);
-  return frame;
-}
-
-bool Tuya::sendFrame(const TuyaFrame& frame) const {
-  _pSerial->write(frame.header[0]);
-  _pSerial->write(frame.header[1]);
-  _pSerial->write(frame.version);
-  _pSerial->write(frame.command);
-  _pSerial->write(frame.length[0]);
-  _pSerial->write(frame.length[1]);
-  _pSerial->write(frame.data, (frame.length[0] << 8) | frame.length[1]);
-  _pSerial->write(frame.checksum);
-  _pSerial->flush();
+    memcpy(buffer->bytes + TUYA_HEADER_SIZE, data, dataLength);
+  }
+  buffer->size = TUYA_HEADER_SIZE + dataLength;
+  buffer->bytes[buffer->size] = tuyaChecksum(buffer->bytes, buffer->size);
+  buffer->size++;
+  return buffer;
+}
+
+bool Tuya::startRequest(TuyaCommandType command, uint8_t maxAttempts, TuyaRequestCallback callback, void* context) {
+  return _requests.start(command, _handshakeInterval, maxAttempts, callback, context);
+}
+
+bool Tuya::completeRequest(TuyaCommandType command) {
+  return _requests.complete(command);
+}
+
+bool Tuya::sendFrame(TuyaFrameBuffer* buffer) {
+  if (buffer == nullptr) {
+    _stats.txDropped++;
+    return false;
+  }
+  // A passive sniffer must never drive the line
+  if (_passive) {
+    _pool.release(buffer);
+    return false;
+  }
+
+  if (!_txQueue.push(buffer)) {
+    _pool.release(buffer);
+    _stats.txDropped++;
+    return false;
+  }
   return true;
 }
 
-void Tuya::decodeFrame(TuyaFrame& frame) {
-  if (_debug) {
-    printFrame(frame);
+bool Tuya::sendFrame(const uint8_t* bytes, uint16_t size) {
+  if (size > TUYA_FRAME_BUFFER_SIZE) {
+    _stats.txDropped++;
+    return false;
+  }
+
+  TuyaFrameBuffer* buffer = acquireFrame();
+  if (buffer == nullptr) {
+    _stats.txDropped++;
+    return false;
   }
 
+  memcpy(buffer->bytes, bytes, size);
+  buffer->size = size;
+  return sendFrame(buffer);
+}
+
+TuyaFrameBuffer* Tuya::acquireFrame() {
+  TuyaFrameBuffer* buffer = _pool.acquire();
+  if (buffer == nullptr && _txQueue.size() > 0) {
+    // Every buffer is waiting in the queue, write them out now rather than
+    // dropping the new frame
+    transmitFrames();
+    buffer = _pool.acquire();
+  }
+  return buffer;
+}
+
+void Tuya::transmitFrames() {
+  if (_pSerial == nullptr || _txQueue.size() == 0) {
+    return;
+  }
+
+  TuyaFrameBuffer* buffer;
+  while ((buffer = _txQueue.pop()) != nullptr) {
+    _pSerial->write(buffer->bytes, buffer->size);
+    _pLog->frame(_id, LOG_FRAME_TX, buffer->bytes, buffer->size);
+    _stats.txFrames[tuyaStatsSlot(buffer->bytes[3])]++;
+    _stats.bytesOut += buffer->size;
+    _roundTrips.observe(MODULE, buffer->bytes[3], micros());
+    if (_pCapture != nullptr) {
+      _pCapture->write(CAPTURE_TX, buffer->bytes, buffer->size);
+    }
+    _pool.release(buffer);
+  }
+
+  if (_flushOnSend) {
+    _pSerial->flush();
+  }
+}
+
+void Tuya::countResult(TuyaErrorTransmission result) {
+  switch (result) {
+  case ERROR_CHECKSUM:
+    _stats.checksumErrors++;
+    break;
+  case ERROR_OVERFLOW:
+    _stats.overflowErrors++;
+    break;
+  default:
+    break;
+  }
+}
+
+void Tuya::processFrame(const TuyaFrameView& frame) {
+  uint32_t now = millis();
+  if (_frameSeen) {
+    _stats.interArrival.add(now - _lastFrameAt);
+  }
+  _lastFrameAt = now;
+  _frameSeen = true;
+  _stats.rxFrames[tuyaStatsSlot(frame.command)]++;
+  _roundTrips.observe(MCU, frame.command, frame.timestamp);
+
+  if (_pCapture != nullptr) {
+    _pCapture->write(CAPTURE_RX, _pCapture->timestampAt(frame.timestamp), _parser.frame(), _parser.frameSize());
+  }
+  _pLog->frame(_id, LOG_FRAME_RX, _parser.frame(), _parser.frameSize());
+
+  decodeFrame(frame);
+  bool initialized = _state.heartbeats && _state.productInfo && _state.workingMode;
+  if (initialized && (!_state.initialized || _warm)) {
+    // A warm start already counted as initialized at begin()
+    if (!_state.initialized) {
+      _stats.timeToInitialized = now - _beganAt;
+    }
+    _warm = false;
+    // One bulk query instead of waiting for the MCU to report each DP
+    if (!_passive) {
+      startRequest(QUERY_DP_STATUS, TUYA_DP_QUERY_ATTEMPTS, handshakeResult, this);
+    }
+  }
+  _state.initialized = initialized || _warm;
+
+  if (!_ready && isReady()) {
+    _ready = true;
+    _stats.timeToReady = now - _beganAt;
+  }
+}
+
+// Frames the real module sent, counted as TX. Its requests carry no state
+// the handlers want, only its network status is kept.
+void Tuya::processModuleFrame(const TuyaFrameView& frame) {
+  _stats.txFrames[tuyaStatsSlot(frame.command)]++;
+  _roundTrips.observe(MODULE, frame.command, frame.timestamp);
+
+  if (_pCapture != nullptr) {
+    _pCapture->write(CAPTURE_TX, _pCapture->timestampAt(frame.timestamp), _moduleParser.frame(),
+      _moduleParser.frameSize());
+  }
+  _pLog->frame(_id, LOG_FRAME_TX, _moduleParser.frame(), _moduleParser.frameSize());
+
+  bool networkStatus = frame.command == REPORT_NETWORK_STATUS || frame.command == GET_CURRENT_NETWORK_STATUS;
+  if (networkStatus && frame.length == 1) {
+    _state.networkStatus = static_cast<TuyaNetworkStatus>(frame.data[0]);
+  }
+}
+
+void Tuya::decodeFrame(const TuyaFrameView& frame) {
   switch (frame.command) {
   case HEARTBEATS:
     handleHeartbeats(frame);
@@ -182,6 +563,9 @@ void Tuya::decodeFrame(TuyaFrame& frame) {
   case REPORT_STATUS_ASYNC:
     handleReportStatusAsync(frame);
     break;
+  case REPORT_STATUS_SYNC:
+    handleReportStatusSync(frame);
+    break;
   case GET_CURRENT_NETWORK_STATUS:
     handleGetCurrentNetworkStatus(frame);
     break;
@@ -194,154 +578,281 @@ void Tuya::decodeFrame(TuyaFrame& frame) {
   }
 }
 
-void Tuya::printFrame(const TuyaFrame& frame) const {
-  _pDebugSerial->print("Received frame: ");
-  _pDebugSerial->print("header[0]: ");
-  _pDebugSerial->print(frame.header[0], HEX);
-  _pDebugSerial->print(", header[1]: ");
-  _pDebugSerial->print(frame.header[1], HEX);
-  _pDebugSerial->print(", version: ");
-  _pDebugSerial->print(frame.version, HEX);
-  _pDebugSerial->print(", command: ");
-  _pDebugSerial->print(frame.command, HEX);
-  _pDebugSerial->print(", length[0]: ");
-  _pDebugSerial->print(frame.length[0], HEX);
-  _pDebugSerial->print(", length[1]: ");
-  _pDebugSerial->print(frame.length[1], HEX);
-  _pDebugSerial->print(", data: ");
-  for (uint16_t i = 0; i < ((frame.length[0] << 8) | frame.length[1]); i++) {
-    _pDebugSerial->print(frame.data[i], HEX);
-    _pDebugSerial->print(" ");
-  }
-  _pDebugSerial->print(", checksum: ");
-  _pDebugSerial->println(frame.checksum, HEX);
-}
-
 void Tuya::setNetworkStatus(TuyaNetworkStatus status) {
   _state.networkStatus = status;
   reportNetworkStatus();
 }
 
-void Tuya::reportNetworkStatus() const {
-  _pDebugSerial->println("Report network status");
-  uint8_t data[1] = { _state.networkStatus };
-  TuyaFrame frame = generateFrame(MODULE, REPORT_NETWORK_STATUS, data, sizeof(data));
-  sendFrame(frame);
+void Tuya::reportNetworkStatus() {
+  _pLog->info(_id, "Report network status");
+  static constexpr TuyaStaticFrame<MODULE, REPORT_NETWORK_STATUS, 1> prototype;
+  TuyaStaticFrame<MODULE, REPORT_NETWORK_STATUS, 1> frame = prototype;
+  frame.set(0, _state.networkStatus);
+  sendFrame(frame.bytes, frame.size);
 }
 
-void Tuya::sendNetworkStatus() const {
-  uint8_t data[1] = { _state.networkStatus };
-  TuyaFrame frame = generateFrame(MODULE, GET_CURRENT_NETWORK_STATUS, data, sizeof(data));
-  sendFrame(frame);
+void Tuya::sendNetworkStatus() {
+  static constexpr TuyaStaticFrame<MODULE, GET_CURRENT_NETWORK_STATUS, 1> prototype;
+  TuyaStaticFrame<MODULE, GET_CURRENT_NETWORK_STATUS, 1> frame = prototype;
+  frame.set(0, _state.networkStatus);
+  sendFrame(frame.bytes, frame.size);
 }
 
-void Tuya::sendHeartbeats() const {
-  TuyaFrame frame = generateFrame(MODULE, HEARTBEATS);
-  sendFrame(frame);
+void Tuya::sendHeartbeats() {
+  static constexpr TuyaStaticFrame<MODULE, HEARTBEATS> frame;
+  sendFrame(frame.bytes, frame.size);
 }
 
-void Tuya::queryProductInfo() const {
-  TuyaFrame frame = generateFrame(MODULE, QUERY_PRODUCT_INFO);
-  sendFrame(frame);
-  delay(_delay);
+void Tuya::sendStatusSyncResponse(bool success) {
+  static constexpr TuyaStaticFrame<MODULE, RESPONSE_STATUS_SYNC, 1> prototype;
+  TuyaStaticFrame<MODULE, RESPONSE_STATUS_SYNC, 1> frame = prototype;
+  frame.set(0, success ? 0x01 : 0x00);
+  sendFrame(frame.bytes, frame.size);
 }
 
-void Tuya::queryWorkingMode() const {
-  TuyaFrame frame = generateFrame(MODULE, QUERY_WORKING_MODE);
-  sendFrame(frame);
-  delay(_delay);
+void Tuya::sendQuery(uint8_t command) {
+  if (command == QUERY_DP_STATUS) {
+    _reportsSinceQuery = 0;
+  }
+  sendFrame(generateFrame(MODULE, static_cast<TuyaCommandType>(command), nullptr, 0));
 }
 
-bool Tuya::decodeHeartbeats(TuyaFrame& frame) {
+// Each query goes out once and is only resent when its reply times out
+void Tuya::startHandshake() {
+  if (!_state.productInfo) {
+    startRequest(QUERY_PRODUCT_INFO, TUYA_REQUEST_RETRY_FOREVER, handshakeResult, this);
+  }
+  if (!_state.workingMode) {
+    startRequest(QUERY_WORKING_MODE, TUYA_REQUEST_RETRY_FOREVER, handshakeResult, this);
+  }
+}
+
+// Only a snapshot with product info, working mode and a subclass state that
+// restores cleanly counts; anything else is a cold start
+void Tuya::warmStart() {
+  if (_pStore == nullptr || _state.initialized || !restoreSnapshot()) {
+    return;
+  }
+
+  _pLog->info(_id, "Warm start from snapshot");
+  _warm = true;
+  _state.initialized = true;
+  if (isReady()) {
+    _ready = true;
+    _stats.timeToReady = 0;
+  }
+}
+
+bool Tuya::restoreSnapshot() {
+  uint8_t blob[TUYA_SNAPSHOT_SIZE];
+  size_t length = _pStore->load(blob, sizeof(blob));
+  if (length < TUYA_SNAPSHOT_OVERHEAD || length > sizeof(blob)) {
+    return false;
+  }
+  if (blob[0] != 'T' || blob[1] != 'S' || blob[2] != TUYA_SNAPSHOT_VERSION) {
+    return false;
+  }
+  uint16_t payload = blob[3] | (blob[4] << 8);
+  uint16_t crc = blob[length - 2] | (blob[length - 1] << 8);
+  if (static_cast<size_t>(payload) + TUYA_SNAPSHOT_OVERHEAD != length || crc != tuyaCrc16(blob, length - 2)) {
+    return false;
+  }
+
+  TuyaSnapshotReader reader(blob + TUYA_SNAPSHOT_HEADER_SIZE, payload);
+  TuyaProductInformation information = {};
+  information.operationMode = reader.getU16();
+  reader.getString(information.productId, sizeof(information.productId));
+  reader.getString(information.version, sizeof(information.version));
+  uint8_t sectionLength = reader.getU8();
+  const uint8_t* section = reader.getBytes(sectionLength);
+  if (reader.failed()) {
+    return false;
+  }
+
+  TuyaSnapshotReader sectionReader(section, sectionLength);
+  if (!restoreState(sectionReader)) {
+    return false;
+  }
+  _state.information = information;
+  _snapshotCrc = crc;
+  _snapshotCrcValid = true;
   return true;
 }
 
-bool Tuya::decodeProductInfo(TuyaFrame& frame) {
-  uint16_t length = (frame.length[0] << 8) | frame.length[1];
-  String productInfo = hexToString(frame.data, length);
+void Tuya::heartbeatTask(void* context) {
+  static_cast<Tuya*>(context)->sendHeartbeats();
+}
+
+void Tuya::snapshotTask(void* context) {
+  Tuya* tuya = static_cast<Tuya*>(context);
+  bool readingsDue = tuya->_readingsChanged && millis() - tuya->_snapshotAt >= TUYA_SNAPSHOT_READINGS_INTERVAL;
+  if (tuya->_stateChanged || readingsDue) {
+    tuya->saveSnapshot();
+  }
+}
 
-  JsonDocument json;
-  if (DeserializationError error = deserializeJson(json, productInfo)) {
+void Tuya::requestSender(uint8_t command, void* context) {
+  static_cast<Tuya*>(context)->sendQuery(command);
+}
+
+void Tuya::handshakeResult(uint8_t command, TuyaRequestResult result, void* context) {
+  Tuya* tuya = static_cast<Tuya*>(context);
+  if (result != REQUEST_COMPLETED) {
+    tuya->_pLog->warn(tuya->_id, "Handshake request gave up, command: ", command);
+  }
+}
+
+bool Tuya::decodeHeartbeats(const TuyaFrameView& frame) {
+  return true;
+}
+
+bool Tuya::decodeProductInfo(const TuyaFrameView& frame) {
+  TuyaProductInformation information = {};
+  TuyaJsonScanner json(frame.data, frame.length);
+  TuyaJsonField field;
+  int32_t operationMode;
+  while (json.next(field)) {
+    if (field.is("product_id")) {
+      field.copyString(information.productId, sizeof(information.productId));
+    } else if (field.is("version")) {
+      field.copyString(information.version, sizeof(information.version));
+    } else if (field.is("operation_mode") && field.toInteger(operationMode)) {
+      information.operationMode = operationMode;
+    }
+  }
+
+  if (!json.complete()) {
     return false;
   }
+  _state.information = information;
+  return true;
+}
 
-  _state.information.productId = json["product_id"].as<String>();
-  _state.information.version = json["version"].as<String>();
-  _state.information.operationMode = json["operation_mode"].as<uint16_t>();
+bool Tuya::decodeQueryWorkingMode(const TuyaFrameView& frame) {
+  return true;
+}
 
+bool Tuya::decodeReportStatusAsync(const TuyaFrameView& frame) {
   return true;
 }
 
-bool Tuya::decodeQueryWorkingMode(TuyaFrame& frame) {
+// Subclass part of the snapshot, at most 255 bytes. Return false to skip the
+// write.
+bool Tuya::saveState(TuyaSnapshotWriter& writer) const {
   return true;
 }
 
-bool Tuya::decodeReportStatusAsync(TuyaFrame& frame) {
+// Reads back what saveState() wrote. Return false, with the state left
+// untouched, when the data does not fit; nothing is restored then.
+bool Tuya::restoreState(TuyaSnapshotReader& reader) {
   return true;
 }
 
-String Tuya::hexToString(uint8_t* data, uint16_t length) const {
-  String result = "";
-  for (uint16_t i = 0; i < length; i++) {
-    result += char(data[i]);
-  }
-  return result;
+// Marks the configuration in the snapshot as stale, the next snapshot timer
+// writes it
+void Tuya::stateChanged() {
+  _stateChanged = true;
 }
 
-void Tuya::handleHeartbeats(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received heartbeats");
-  }
-  _state.heartbeats = decodeHeartbeats(frame);
+// Marks the readings in the snapshot as stale, they are only written with a
+// configuration change or after TUYA_SNAPSHOT_READINGS_INTERVAL
+void Tuya::readingsChanged() {
+  _readingsChanged = true;
+}
+
+// Number of DPs a full status report carries, 0 when unknown
+uint8_t Tuya::dataPointCount() const {
+  return 0;
 }
 
-void Tuya::handleQueryProductInfo(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received query product info");
+// Same DP payload as the async report, by default decoded the same way
+bool Tuya::decodeReportStatusSync(const TuyaFrameView& frame) {
+  return decodeReportStatusAsync(frame);
+}
+
+void Tuya::handleHeartbeats(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received heartbeats");
+  bool heartbeats = decodeHeartbeats(frame);
+  if (heartbeats && !_state.heartbeats && !_passive) {
+    _scheduler.setInterval(_heartbeatTimer, 15000);
+    startHandshake();
   }
-  _state.productInfo = decodeProductInfo(frame);
+  _state.heartbeats = heartbeats;
 }
 
-void Tuya::handleQueryWorkingMode(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received query working mode");
+void Tuya::handleQueryProductInfo(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received query product info");
+  _state.productInfo = decodeProductInfo(frame);
+  // A reply that fails to decode leaves the request to be retried
+  if (_state.productInfo) {
+    completeRequest(QUERY_PRODUCT_INFO);
+    stateChanged();
   }
-  _state.workingMode = decodeQueryWorkingMode(frame);
 }
 
-void Tuya::handleReportNetworkStatus(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received report network status");
+void Tuya::handleQueryWorkingMode(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received query working mode");
+  _state.workingMode = decodeQueryWorkingMode(frame);
+  if (_state.workingMode) {
+    completeRequest(QUERY_WORKING_MODE);
+    stateChanged();
   }
+}
+
+void Tuya::handleReportNetworkStatus(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received report network status");
   // Do nothing for now
 }
 
-void Tuya::handleReportStatusAsync(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received report status");
+// The reply to QUERY_DP_STATUS is an ordinary report, so an unsolicited
+// single-DP report must not pass for it. When the device knows its DP count
+// only a report with every DP answers it; otherwise the first decoded report
+// after the query with more than one DP does. Anything else leaves the query
+// to be resent on timeout.
+void Tuya::handleReportStatusAsync(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received report status");
+  if (!decodeReportStatusAsync(frame)) {
+    return;
+  }
+  bool first = _reportsSinceQuery == 0;
+  if (_reportsSinceQuery < UINT8_MAX) {
+    _reportsSinceQuery++;
   }
-  decodeReportStatusAsync(frame);
-}
 
-void Tuya::handleGetCurrentNetworkStatus(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received get current network status");
+  uint8_t count = 0;
+  TuyaDataPoint dataPoint;
+  TuyaDataPointReader reader(frame);
+  while (reader.next(dataPoint) && count < UINT8_MAX) {
+    count++;
+  }
+  uint8_t expected = dataPointCount();
+  if (expected > 0 ? count >= expected : first && count > 1) {
+    completeRequest(QUERY_DP_STATUS);
   }
+}
+
+// The MCU waits for the ack and may resend the report without it
+void Tuya::handleReportStatusSync(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received report status sync");
+  sendStatusSyncResponse(decodeReportStatusSync(frame));
+}
+
+void Tuya::handleGetCurrentNetworkStatus(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received get current network status");
   sendNetworkStatus();
 }
 
-void Tuya::handleResetWiFiPairMode(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received reset WiFi pair mode");
-  }
+void Tuya::handleResetWiFiPairMode(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received reset WiFi pair mode");
 
   if (_onResetWiFiPairMode != nullptr) {
     _onResetWiFiPairMode();
   }
+  if (_onResetWiFiPairModeDevice != nullptr) {
+    _onResetWiFiPairModeDevice(*this, _onResetWiFiPairModeContext);
+  }
 }
 
-void Tuya::handleUnknownCommand(TuyaFrame& frame) {
-  if (_debug) {
-    _pDebugSerial->println("Received unknown command");
-  }
+void Tuya::handleUnknownCommand(const TuyaFrameView& frame) {
+  _pLog->debug(_id, "Received unknown command");
 }
\ No newline at end of file
@@ -3,16 +3,28 @@
 
 #include <Arduino.h>
 #include <Stream.h>
-#include <ArduinoJson.h>
+#include "tuya_frame.h"
+#include "tuya_parser.h"
+#include "tuya_scheduler.h"
+#include "tuya_request.h"
+#include "tuya_capture.h"
+#include "tuya_log.h"
+#include "tuya_stats.h"
+#include "tuya_round_trip.h"
+#include "tuya_json.h"
+#include "tuya_snapshot.h"
+
+// Id of a device that is not part of a bus
+#define TUYA_NO_DEVICE_ID TUYA_LOG_NO_SOURCE
+
+// Attempts of the DP status query sent once initialized
+#define TUYA_DP_QUERY_ATTEMPTS 3
+
+// Product info fields, longer values are truncated
+#define TUYA_PRODUCT_ID_SIZE 32
+#define TUYA_VERSION_SIZE 16
 
 // Enums for various Tuya types
-enum TuyaErrorTransmission {
-  ERROR_NONE = 0,
-  ERROR_NO_DATA,
-  ERROR_CHECKSUM,
-  ERROR_OVERFLOW,
-};
-
 enum TuyaDataType {
   DT_RAW = 0x00,
   DT_BOOLEAN = 0x01,
@@ -70,18 +82,9 @@ enum TuyaNetworkStatus {
 };
 
 // Structs for Tuya data
-struct TuyaFrame {
-  uint8_t header[2];
-  uint8_t version;
-  uint8_t command;
-  uint8_t length[2];
-  uint8_t data[1024];
-  uint8_t checksum;
-};
-
 struct TuyaProductInformation {
-  String productId;
-  String version;
+  char productId[TUYA_PRODUCT_ID_SIZE];
+  char version[TUYA_VERSION_SIZE];
   uint16_t operationMode;
 };
 
@@ -100,62 +103,141 @@ public:
   Tuya();
 
   void begin(Stream* pSerial);
+  void beginPassive(Stream* pMcuSerial, Stream* pModuleSerial);
+  bool isPassive() const;
   void loop();
+  void feed(const uint8_t* bytes, size_t length);
+  uint32_t timeUntilNext();
+
+  void setId(uint8_t id);
+  uint8_t getId() const;
+  void setLog(TuyaLog* log);
 
   void debug(Stream& stream, bool enable);
-  void setDelay(uint32_t delay);
+  void setLogAutoFlush(bool enable);
+  TuyaLog& logger();
+  void capture(TuyaCaptureWriter* writer);
+  void persist(TuyaStateStore* store, uint32_t interval = TUYA_SNAPSHOT_INTERVAL);
+  bool saveSnapshot();
+  void setHandshakeInterval(uint32_t interval);
+  void setFlushOnSend(bool enable);
   void setNetworkStatus(TuyaNetworkStatus status);
 
   bool isInitialized() const;
+  virtual bool isReady() const;
+  bool isWarm() const;
   TuyaNetworkStatus getNetworkStatus() const;
   TuyaProductInformation getProductInformation() const;
+  const TuyaStats& getStats();
+  void resetStats();
+  const TuyaRoundTripStats& getRoundTripStats() const;
 
   void onResetWiFiPairMode(void (*callback)());
+  void onResetWiFiPairMode(void (*callback)(Tuya& device, void* context), void* context);
+
+  int8_t every(uint32_t interval, TuyaTimerCallback callback, void* context = nullptr);
+  int8_t after(uint32_t delay, TuyaTimerCallback callback, void* context = nullptr);
+  void cancel(int8_t timer);
 
 protected:
-  virtual bool decodeHeartbeats(TuyaFrame& frame);
-  virtual bool decodeProductInfo(TuyaFrame& frame);
-  virtual bool decodeQueryWorkingMode(TuyaFrame& frame);
-  virtual bool decodeReportStatusAsync(TuyaFrame& frame);
+  virtual bool decodeHeartbeats(const TuyaFrameView& frame);
+  virtual bool decodeProductInfo(const TuyaFrameView& frame);
+  virtual bool decodeQueryWorkingMode(const TuyaFrameView& frame);
+  virtual bool decodeReportStatusAsync(const TuyaFrameView& frame);
+  virtual bool decodeReportStatusSync(const TuyaFrameView& frame);
+  virtual uint8_t dataPointCount() const;
+
+  TuyaFrameBuffer* generateFrame(TuyaDeviceType version, TuyaCommandType command, const uint8_t* data, uint16_t dataLength);
+
+  bool sendFrame(TuyaFrameBuffer* buffer);
+  bool sendFrame(const uint8_t* bytes, uint16_t size);
 
-  TuyaFrame generateFrame(TuyaDeviceType version, TuyaCommandType command, uint8_t* data, uint16_t dataLength) const;
-  TuyaFrame generateFrame(TuyaDeviceType version, TuyaCommandType command) const;
+  virtual bool saveState(TuyaSnapshotWriter& writer) const;
+  virtual bool restoreState(TuyaSnapshotReader& reader);
+  void stateChanged();
+  void readingsChanged();
 
-  bool sendFrame(const TuyaFrame& frame) const;
+  int8_t everyInternal(uint32_t interval, TuyaTimerCallback callback, void* context);
+  void cancelInternal(int8_t timer);
+
+  bool startRequest(TuyaCommandType command, uint8_t maxAttempts = TUYA_REQUEST_RETRY_FOREVER,
+    TuyaRequestCallback callback = nullptr, void* context = nullptr);
+  bool completeRequest(TuyaCommandType command);
 
 private:
-  uint32_t _delay;
+  uint8_t _id;
+  uint32_t _handshakeInterval;
   Stream* _pSerial;
-  Stream* _pDebugSerial;
+  Stream* _pModuleSerial;
+  bool _passive;
   TuyaModuleInformation _state;
-  uint32_t intervalHeartbeats = 1000;
-  uint32_t _lastHeartbeats = 0;
-  bool _debug;
+  TuyaFrameParser _parser;
+  TuyaFrameParser _moduleParser;
+  TuyaFramePool _pool;
+  TuyaFrameQueue _txQueue;
+  bool _flushOnSend;
+  TuyaScheduler _scheduler;
+  uint8_t _internalTimers;
+  TuyaRequestTracker _requests;
+  int8_t _heartbeatTimer;
+  TuyaLog* _pLog;
+  bool _logAutoFlush;
+  TuyaStats _stats;
+  TuyaRoundTripTracker _roundTrips;
+  uint32_t _beganAt;
+  uint32_t _lastFrameAt;
+  bool _frameSeen;
+  bool _ready;
+  uint8_t _reportsSinceQuery;
+  TuyaCaptureWriter* _pCapture;
+  TuyaStateStore* _pStore;
+  int8_t _snapshotTimer;
+  uint16_t _snapshotCrc;
+  bool _snapshotCrcValid;
+  bool _stateChanged;
+  bool _readingsChanged;
+  uint32_t _snapshotAt;
+  bool _warm;
   void (*_onResetWiFiPairMode)();
-
-  TuyaErrorTransmission listeningMessage(TuyaFrame& frame);
-  bool validateChecksum(const TuyaFrame& frame) const;
-  uint8_t generateChecksum(const TuyaFrame& frame) const;
-
-  void decodeFrame(TuyaFrame& frame);
-  void printFrame(const TuyaFrame& frame) const;
-
-  void handleHeartbeats(TuyaFrame& frame);
-  void handleQueryProductInfo(TuyaFrame& frame);
-  void handleQueryWorkingMode(TuyaFrame& frame);
-  void handleReportNetworkStatus(TuyaFrame& frame);
-  void handleReportStatusAsync(TuyaFrame& frame);
-  void handleGetCurrentNetworkStatus(TuyaFrame& frame);
-  void handleResetWiFiPairMode(TuyaFrame& frame);
-  void handleUnknownCommand(TuyaFrame& frame);
-
-  void sendNetworkStatus() const;
-  void reportNetworkStatus() const;
-  void sendHeartbeats() const;
-  void queryProductInfo() const;
-  void queryWorkingMode() const;
-
-  String hexToString(uint8_t* data, uint16_t length) const;
+  void (*_onResetWiFiPairModeDevice)(Tuya& device, void* context);
+  void* _onResetWiFiPairModeContext;
+
+  TuyaErrorTransmission listeningMessage(Stream* pSerial, TuyaFrameParser& parser, uint32_t& bytes, uint32_t timestamp,
+    TuyaFrameView& frame);
+  bool readFrame(Stream* pSerial, TuyaFrameParser& parser, uint32_t& bytes, uint32_t timestamp, TuyaFrameView& frame);
+  void readPassive(uint32_t timestamp);
+
+  TuyaFrameBuffer* acquireFrame();
+  void transmitFrames();
+
+  void countResult(TuyaErrorTransmission result);
+  void processFrame(const TuyaFrameView& frame);
+  void processModuleFrame(const TuyaFrameView& frame);
+  void decodeFrame(const TuyaFrameView& frame);
+
+  void handleHeartbeats(const TuyaFrameView& frame);
+  void handleQueryProductInfo(const TuyaFrameView& frame);
+  void handleQueryWorkingMode(const TuyaFrameView& frame);
+  void handleReportNetworkStatus(const TuyaFrameView& frame);
+  void handleReportStatusAsync(const TuyaFrameView& frame);
+  void handleReportStatusSync(const TuyaFrameView& frame);
+  void handleGetCurrentNetworkStatus(const TuyaFrameView& frame);
+  void handleResetWiFiPairMode(const TuyaFrameView& frame);
+  void handleUnknownCommand(const TuyaFrameView& frame);
+
+  void sendNetworkStatus();
+  void reportNetworkStatus();
+  void sendHeartbeats();
+  void sendStatusSyncResponse(bool success);
+  void sendQuery(uint8_t command);
+  void startHandshake();
+  void warmStart();
+  bool restoreSnapshot();
+
+  static void heartbeatTask(void* context);
+  static void snapshotTask(void* context);
+  static void requestSender(uint8_t command, void* context);
+  static void handshakeResult(uint8_t command, TuyaRequestResult result, void* context);
 };
 
 #endif // TUYA_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "tuya_alarm.h"
+
+TuyaAlarm::TuyaAlarm()
+  : _config({ 0, 1 }), _raised(false), _streak(0), _raisedAt(0), _clearedAt(0), _raisedCount(0) {
+}
+
+void TuyaAlarm::configure(const TuyaAlarmConfig& config) {
+  _config = config;
+  _streak = 0;
+}
+
+const TuyaAlarmConfig& TuyaAlarm::config() const {
+  return _config;
+}
+
+void TuyaAlarm::reset() {
+  _raised = false;
+  _streak = 0;
+  _raisedAt = 0;
+  _clearedAt = 0;
+  _raisedCount = 0;
+}
+
+TuyaAlarmEdge TuyaAlarm::evaluate(int32_t excess, uint32_t now) {
+  if (!isCrossing(excess)) {
+    _streak = 0;
+    return ALARM_NONE;
+  }
+
+  if (_streak < UINT8_MAX) {
+    _streak++;
+  }
+  if (_streak < _config.debounce) {
+    return ALARM_NONE;
+  }
+  return toggle(now);
+}
+
+TuyaAlarmEdge TuyaAlarm::recheck(int32_t excess, uint32_t now) {
+  if (!isCrossing(excess)) {
+    _streak = 0;
+    return ALARM_NONE;
+  }
+  if (_config.debounce > 1) {
+    return ALARM_NONE;
+  }
+  return toggle(now);
+}
+
+bool TuyaAlarm::raised() const {
+  return _raised;
+}
+
+uint32_t TuyaAlarm::raisedAt() const {
+  return _raisedAt;
+}
+
+uint32_t TuyaAlarm::clearedAt() const {
+  return _clearedAt;
+}
+
+// Time spent raised: up to now while raised, the last episode once cleared
+uint32_t TuyaAlarm::duration(uint32_t now) const {
+  if (_raisedCount == 0) {
+    return 0;
+  }
+  return (_raised ? now : _clearedAt) - _raisedAt;
+}
+
+uint32_t TuyaAlarm::raisedCount() const {
+  return _raisedCount;
+}
+
+bool TuyaAlarm::isCrossing(int32_t excess) const {
+  return _raised ? excess <= -_config.hysteresis : excess > 0;
+}
+
+TuyaAlarmEdge TuyaAlarm::toggle(uint32_t now) {
+  _streak = 0;
+  _raised = !_raised;
+  if (_raised) {
+    _raisedAt = now;
+    _raisedCount++;
+    return ALARM_RAISED;
+  }
+  _clearedAt = now;
+  return ALARM_CLEARED;
+}
@@ -0,0 +1,56 @@
+#ifndef TUYA_ALARM_H
+#define TUYA_ALARM_H
+
+#include <Arduino.h>
+
+// Structs for alarm evaluation. hysteresis is in wire units of the value;
+// debounce is the number of consecutive samples needed to change state, 0
+// and 1 both act on the first sample.
+struct TuyaAlarmConfig {
+  int32_t hysteresis;
+  uint8_t debounce;
+};
+
+enum TuyaAlarmEdge {
+  ALARM_NONE,
+  ALARM_RAISED,
+  ALARM_CLEARED,
+};
+
+// Edge-triggered limit check. evaluate() takes how far a sample is past the
+// limit (value - threshold for a high limit, threshold - value for a low
+// one): the alarm is raised once debounce samples in a row are past it, and
+// cleared once debounce samples in a row are back by at least hysteresis.
+// Samples in between keep the state and restart the count. recheck() is for
+// a limit that moved without a new sample: it can break a streak but never
+// extends one, so only a debounce of 0 or 1 changes state from it.
+class TuyaAlarm {
+public:
+  TuyaAlarm();
+
+  void configure(const TuyaAlarmConfig& config);
+  const TuyaAlarmConfig& config() const;
+  void reset();
+
+  TuyaAlarmEdge evaluate(int32_t excess, uint32_t now);
+  TuyaAlarmEdge recheck(int32_t excess, uint32_t now);
+
+  bool raised() const;
+  uint32_t raisedAt() const;
+  uint32_t clearedAt() const;
+  uint32_t duration(uint32_t now) const;
+  uint32_t raisedCount() const;
+
+private:
+  TuyaAlarmConfig _config;
+  bool _raised;
+  uint8_t _streak;
+  uint32_t _raisedAt;
+  uint32_t _clearedAt;
+  uint32_t _raisedCount;
+
+  bool isCrossing(int32_t excess) const;
+  TuyaAlarmEdge toggle(uint32_t now);
+};
+
+#endif // TUYA_ALARM_H
@@ -0,0 +1,44 @@
+#include "tuya_capture.h"
+
+TuyaCaptureWriter::TuyaCaptureWriter(Print& output)
+  : _output(output), _lastMicros(0), _wraps(0) {
+}
+
+void TuyaCaptureWriter::begin() {
+  uint8_t header[TUYA_CAPTURE_HEADER_SIZE];
+  memcpy(header, TUYA_CAPTURE_MAGIC, TUYA_CAPTURE_HEADER_SIZE - 1);
+  header[TUYA_CAPTURE_HEADER_SIZE - 1] = TUYA_CAPTURE_VERSION;
+  _output.write(header, sizeof(header));
+}
+
+void TuyaCaptureWriter::write(TuyaCaptureDirection direction, const uint8_t* bytes, uint16_t size) {
+  write(direction, timestamp(), bytes, size);
+}
+
+void TuyaCaptureWriter::write(TuyaCaptureDirection direction, uint64_t timestamp, const uint8_t* bytes, uint16_t size) {
+  uint8_t header[TUYA_CAPTURE_RECORD_HEADER_SIZE];
+  for (uint8_t i = 0; i < 8; i++) {
+    header[i] = (timestamp >> (8 * i)) & 0xFF;
+  }
+  header[8] = direction;
+  header[9] = size & 0xFF;
+  header[10] = (size >> 8) & 0xFF;
+
+  _output.write(header, sizeof(header));
+  _output.write(bytes, size);
+}
+
+uint64_t TuyaCaptureWriter::timestamp() {
+  // micros() wraps after about 71 minutes, extend it to 64 bits
+  uint32_t now = micros();
+  if (now < _lastMicros) {
+    _wraps++;
+  }
+  _lastMicros = now;
+  return ((uint64_t)_wraps << 32) | now;
+}
+
+uint64_t TuyaCaptureWriter::timestampAt(uint32_t micros) {
+  uint64_t now = timestamp();
+  return now - (uint32_t)((uint32_t)now - micros);
+}
@@ -0,0 +1,40 @@
+#ifndef TUYA_CAPTURE_H
+#define TUYA_CAPTURE_H
+
+#include <Arduino.h>
+
+// Binary capture format, all integers little-endian:
+//   header: "TUYACAP" magic, uint8 version
+//   record: uint64 timestamp (us), uint8 direction, uint16 length, frame bytes
+#define TUYA_CAPTURE_MAGIC "TUYACAP"
+#define TUYA_CAPTURE_VERSION 1
+#define TUYA_CAPTURE_HEADER_SIZE 8
+#define TUYA_CAPTURE_RECORD_HEADER_SIZE 11
+
+enum TuyaCaptureDirection {
+  CAPTURE_RX = 0x00,
+  CAPTURE_TX = 0x01,
+};
+
+// Writes complete frames with a microsecond timestamp to any Print, e.g. a
+// spare UART or an SD card file.
+class TuyaCaptureWriter {
+public:
+  TuyaCaptureWriter(Print& output);
+
+  void begin();
+  void write(TuyaCaptureDirection direction, const uint8_t* bytes, uint16_t size);
+  void write(TuyaCaptureDirection direction, uint64_t timestamp, const uint8_t* bytes, uint16_t size);
+  // 64-bit capture time of a micros() value from the recent past, e.g. the
+  // arrival of a frame's first byte
+  uint64_t timestampAt(uint32_t micros);
+
+private:
+  Print& _output;
+  uint32_t _lastMicros;
+  uint32_t _wraps;
+
+  uint64_t timestamp();
+};
+
+#endif // TUYA_CAPTURE_H
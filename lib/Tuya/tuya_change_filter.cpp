@@ -0,0 +1,84 @@
+#include "tuya_change_filter.h"
+
+TuyaChangeFilter::TuyaChangeFilter()
+  : _config({ 0, false, 0, 0 }), _enabled(false), _hasValue(false), _published(false), _pending(false),
+    _value(0), _publishedValue(0), _publishedAt(0) {
+}
+
+void TuyaChangeFilter::configure(const TuyaNotifyFilter& config) {
+  _config = config;
+  _enabled = true;
+  _published = false;
+  _pending = false;
+}
+
+void TuyaChangeFilter::disable() {
+  _enabled = false;
+  _pending = false;
+}
+
+bool TuyaChangeFilter::enabled() const {
+  return _enabled;
+}
+
+bool TuyaChangeFilter::report(int32_t value, uint32_t now) {
+  _value = value;
+  _hasValue = true;
+  if (!_enabled) {
+    return true;
+  }
+
+  if (!_published || outsideDeadband(value)) {
+    if (!_published || now - _publishedAt >= _config.minInterval) {
+      publish(now);
+      return true;
+    }
+    _pending = true;
+    return false;
+  }
+
+  // Back inside the deadband, a held back change is no longer a change
+  _pending = false;
+  if (silent(now)) {
+    publish(now);
+    return true;
+  }
+  return false;
+}
+
+bool TuyaChangeFilter::poll(uint32_t now) {
+  if (!_enabled || !_hasValue) {
+    return false;
+  }
+
+  if ((_pending && now - _publishedAt >= _config.minInterval) || silent(now)) {
+    publish(now);
+    return true;
+  }
+  return false;
+}
+
+bool TuyaChangeFilter::outsideDeadband(int32_t value) const {
+  int64_t difference = (int64_t)value - _publishedValue;
+  if (difference < 0) {
+    difference = -difference;
+  }
+
+  int64_t band = _config.deadband;
+  if (_config.relative) {
+    int64_t reference = _publishedValue < 0 ? -(int64_t)_publishedValue : _publishedValue;
+    band = reference * _config.deadband / 1000;
+  }
+  return difference > band;
+}
+
+bool TuyaChangeFilter::silent(uint32_t now) const {
+  return _published && _config.maxSilence > 0 && now - _publishedAt >= _config.maxSilence;
+}
+
+void TuyaChangeFilter::publish(uint32_t now) {
+  _publishedValue = _value;
+  _publishedAt = now;
+  _published = true;
+  _pending = false;
+}
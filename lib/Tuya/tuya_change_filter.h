@@ -0,0 +1,47 @@
+#ifndef TUYA_CHANGE_FILTER_H
+#define TUYA_CHANGE_FILTER_H
+
+#include <Arduino.h>
+
+// Structs for notification filtering. A relative deadband is in per mille of
+// the last published value; maxSilence 0 disables the forced publish.
+struct TuyaNotifyFilter {
+  int32_t deadband;
+  bool relative;
+  uint32_t minInterval;
+  uint32_t maxSilence;
+};
+
+// Decides when a reported value is worth publishing. A value is published
+// when it leaves the deadband around the last published value, but no sooner
+// than minInterval after the previous publish; a change held back by the
+// interval is published by poll() once the interval has passed. After
+// maxSilence without a publish the latest value is published again.
+// A disabled filter publishes every report.
+class TuyaChangeFilter {
+public:
+  TuyaChangeFilter();
+
+  void configure(const TuyaNotifyFilter& config);
+  void disable();
+  bool enabled() const;
+
+  bool report(int32_t value, uint32_t now);
+  bool poll(uint32_t now);
+
+private:
+  TuyaNotifyFilter _config;
+  bool _enabled;
+  bool _hasValue;
+  bool _published;
+  bool _pending;
+  int32_t _value;
+  int32_t _publishedValue;
+  uint32_t _publishedAt;
+
+  bool outsideDeadband(int32_t value) const;
+  bool silent(uint32_t now) const;
+  void publish(uint32_t now);
+};
+
+#endif // TUYA_CHANGE_FILTER_H
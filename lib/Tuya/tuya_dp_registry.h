@@ -0,0 +1,149 @@
+#ifndef TUYA_DP_REGISTRY_H
+#define TUYA_DP_REGISTRY_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "tuya.h"
+
+// Converts a fixed-point wire value to float, e.g. 312 with 1 decimal -> 31.2
+inline float tuyaFixedToFloat(int32_t raw, uint8_t decimals) {
+  static const float factors[] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f };
+  return decimals < sizeof(factors) / sizeof(factors[0]) ? raw / factors[decimals] : raw;
+}
+
+// Describes how one DP maps onto a field of a device's data struct. The
+// target is a byte offset (offsetof) of an int32_t inside TData that holds
+// the value exactly as it arrived on the wire; decimals records its scale.
+template <typename TData>
+struct TuyaDpDescriptor {
+  uint8_t id;
+  TuyaDataType type;
+  uint8_t decimals;
+  uint16_t field;
+  uint16_t offset;
+  bool writable;
+};
+
+// Compile-time DP table with a 256-entry index keyed by DP id, so decoding a
+// DP is a single table lookup regardless of how many DPs a device defines.
+template <typename TData, size_t N>
+class TuyaDpRegistry {
+  static_assert(N < 256, "a registry holds at most 255 data points");
+
+public:
+  constexpr TuyaDpRegistry(const TuyaDpDescriptor<TData> (&descriptors)[N]) : _descriptors(), _index() {
+    for (size_t i = 0; i < N; i++) {
+      _descriptors[i] = descriptors[i];
+      _index[descriptors[i].id] = i + 1;
+    }
+  }
+
+  constexpr size_t size() const {
+    return N;
+  }
+
+  constexpr const TuyaDpDescriptor<TData>& operator[](size_t i) const {
+    return _descriptors[i];
+  }
+
+  constexpr const TuyaDpDescriptor<TData>* find(uint8_t id) const {
+    return _index[id] == 0 ? nullptr : &_descriptors[_index[id] - 1];
+  }
+
+  // Field bits of every DP in the table
+  constexpr uint16_t fields() const {
+    uint16_t mask = 0;
+    for (size_t i = 0; i < N; i++) {
+      mask |= _descriptors[i].field;
+    }
+    return mask;
+  }
+
+  // Field bits of the DPs the module may write, the device's configuration
+  constexpr uint16_t writableFields() const {
+    uint16_t mask = 0;
+    for (size_t i = 0; i < N; i++) {
+      mask |= _descriptors[i].writable ? _descriptors[i].field : 0;
+    }
+    return mask;
+  }
+
+  // Stores the DP into its target field and returns the field bit, or 0 if
+  // the DP is unknown or its type or length does not match the table.
+  uint16_t decode(TData& data, const TuyaDataPoint& dataPoint) const {
+    const TuyaDpDescriptor<TData>* descriptor = find(dataPoint.id);
+    if (descriptor == nullptr || descriptor->type != dataPoint.type || dataPoint.length == 0 || dataPoint.length > 4) {
+      return 0;
+    }
+
+    uint32_t raw = 0;
+    for (uint16_t i = 0; i < dataPoint.length; i++) {
+      raw = (raw << 8) | dataPoint.value[i];
+    }
+
+    int32_t& target = *reinterpret_cast<int32_t*>(reinterpret_cast<uint8_t*>(&data) + descriptor->offset);
+    target = static_cast<int32_t>(raw);
+    return descriptor->field;
+  }
+
+  // Wire value currently held by the descriptor's target field
+  int32_t value(const TData& data, const TuyaDpDescriptor<TData>& descriptor) const {
+    return *reinterpret_cast<const int32_t*>(reinterpret_cast<const uint8_t*>(&data) + descriptor.offset);
+  }
+
+  void setValue(TData& data, const TuyaDpDescriptor<TData>& descriptor, int32_t raw) const {
+    *reinterpret_cast<int32_t*>(reinterpret_cast<uint8_t*>(&data) + descriptor.offset) = raw;
+  }
+
+  // True if the field behind the DP already holds the given wire value
+  bool matches(const TData& data, uint8_t id, int32_t raw) const {
+    const TuyaDpDescriptor<TData>* descriptor = find(id);
+    if (descriptor == nullptr) {
+      return false;
+    }
+
+    return value(data, *descriptor) == raw;
+  }
+
+  // Appends the DP as a TLV in its table type and returns the number of bytes
+  // written, or 0 if the DP is unknown, read-only or does not fit.
+  uint16_t encode(uint8_t* buffer, uint16_t size, uint8_t id, int32_t raw) const {
+    const TuyaDpDescriptor<TData>* descriptor = find(id);
+    if (descriptor == nullptr || !descriptor->writable) {
+      return 0;
+    }
+
+    uint16_t length = valueLength(descriptor->type);
+    if (length == 0 || size < 4 + length) {
+      return 0;
+    }
+
+    buffer[0] = id;
+    buffer[1] = descriptor->type;
+    buffer[2] = (length >> 8) & 0xFF;
+    buffer[3] = length & 0xFF;
+    for (uint16_t i = 0; i < length; i++) {
+      buffer[4 + i] = (raw >> (8 * (length - 1 - i))) & 0xFF;
+    }
+    return 4 + length;
+  }
+
+private:
+  TuyaDpDescriptor<TData> _descriptors[N];
+  uint8_t _index[256];
+
+  static uint16_t valueLength(TuyaDataType type) {
+    switch (type) {
+    case DT_BOOLEAN:
+    case DT_ENUM:
+      return 1;
+    case DT_VALUE:
+    case DT_BITMAP:
+      return 4;
+    default:
+      return 0;
+    }
+  }
+};
+
+#endif // TUYA_DP_REGISTRY_H
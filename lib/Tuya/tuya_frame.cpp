@@ -0,0 +1,96 @@
+#include "tuya_frame.h"
+
+static_assert(TUYA_FRAME_POOL_SIZE <= 32, "the pool tracks buffers in a uint32_t mask");
+
+uint8_t tuyaChecksum(const uint8_t* bytes, uint16_t size) {
+  uint8_t sum = 0;
+  for (uint16_t i = 0; i < size; i++) {
+    sum += bytes[i];
+  }
+  return sum;
+}
+
+TuyaFramePool::TuyaFramePool() : _used(0) {
+}
+
+TuyaFrameBuffer* TuyaFramePool::acquire() {
+  for (uint8_t i = 0; i < TUYA_FRAME_POOL_SIZE; i++) {
+    if (!(_used & (1UL << i))) {
+      _used |= (1UL << i);
+      _buffers[i].size = 0;
+      return &_buffers[i];
+    }
+  }
+  return nullptr;
+}
+
+void TuyaFramePool::release(TuyaFrameBuffer* buffer) {
+  if (buffer < _buffers || buffer >= _buffers + TUYA_FRAME_POOL_SIZE) {
+    return;
+  }
+  _used &= ~(1UL << (buffer - _buffers));
+}
+
+uint8_t TuyaFramePool::available() const {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < TUYA_FRAME_POOL_SIZE; i++) {
+    if (!(_used & (1UL << i))) {
+      count++;
+    }
+  }
+  return count;
+}
+
+TuyaFrameQueue::TuyaFrameQueue() : _head(0), _count(0) {
+}
+
+bool TuyaFrameQueue::push(TuyaFrameBuffer* buffer) {
+  if (_count >= TUYA_FRAME_POOL_SIZE) {
+    return false;
+  }
+  _buffers[(_head + _count) % TUYA_FRAME_POOL_SIZE] = buffer;
+  _count++;
+  return true;
+}
+
+TuyaFrameBuffer* TuyaFrameQueue::pop() {
+  if (_count == 0) {
+    return nullptr;
+  }
+  TuyaFrameBuffer* buffer = _buffers[_head];
+  _head = (_head + 1) % TUYA_FRAME_POOL_SIZE;
+  _count--;
+  return buffer;
+}
+
+uint8_t TuyaFrameQueue::size() const {
+  return _count;
+}
+
+TuyaDataPointReader::TuyaDataPointReader(const TuyaFrameView& frame)
+  : _data(frame.data), _length(frame.length), _offset(0) {
+}
+
+TuyaDataPointReader::TuyaDataPointReader(const uint8_t* data, uint16_t length)
+  : _data(data), _length(length), _offset(0) {
+}
+
+bool TuyaDataPointReader::next(TuyaDataPoint& dataPoint) {
+  if (_offset + 4 > _length) {
+    return false;
+  }
+
+  const uint8_t* entry = _data + _offset;
+  uint16_t valueLength = (entry[2] << 8) | entry[3];
+  if (_offset + 4 + valueLength > _length) {
+    _offset = _length;
+    return false;
+  }
+
+  dataPoint.id = entry[0];
+  dataPoint.type = entry[1];
+  dataPoint.length = valueLength;
+  dataPoint.value = entry + 4;
+  _offset += 4 + valueLength;
+  return true;
+}
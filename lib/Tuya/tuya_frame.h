@@ -0,0 +1,93 @@
+#ifndef TUYA_FRAME_H
+#define TUYA_FRAME_H
+
+#include <Arduino.h>
+
+#define TUYA_HEADER_SIZE 6
+#define TUYA_MAX_DATA_LENGTH 1024
+#define TUYA_MAX_FRAME_SIZE (TUYA_HEADER_SIZE + TUYA_MAX_DATA_LENGTH + 1)
+
+#ifndef TUYA_FRAME_BUFFER_SIZE
+#define TUYA_FRAME_BUFFER_SIZE 64
+#endif
+
+#ifndef TUYA_FRAME_POOL_SIZE
+#define TUYA_FRAME_POOL_SIZE 4
+#endif
+
+// Sum of all bytes modulo 256, as used for the frame checksum
+uint8_t tuyaChecksum(const uint8_t* bytes, uint16_t size);
+
+// Read-only view of a received frame. The payload points into the parser's
+// receive buffer and is only valid until the next byte is pushed. timestamp
+// is the micros() value the first byte was pushed with.
+struct TuyaFrameView {
+  uint8_t version;
+  uint8_t command;
+  uint16_t length;
+  const uint8_t* data;
+  uint8_t checksum;
+  uint32_t timestamp;
+};
+
+// One DP TLV inside a status payload: id, type, big-endian length, value
+struct TuyaDataPoint {
+  uint8_t id;
+  uint8_t type;
+  uint16_t length;
+  const uint8_t* value;
+};
+
+// Walks the DP TLVs of a payload using each entry's length field. Stops at
+// the end of the payload or at the first entry that would run past it.
+class TuyaDataPointReader {
+public:
+  TuyaDataPointReader(const TuyaFrameView& frame);
+  TuyaDataPointReader(const uint8_t* data, uint16_t length);
+
+  bool next(TuyaDataPoint& dataPoint);
+
+private:
+  const uint8_t* _data;
+  uint16_t _length;
+  uint16_t _offset;
+};
+
+// Serialized outgoing frame: header, payload and checksum back to back
+struct TuyaFrameBuffer {
+  uint8_t bytes[TUYA_FRAME_BUFFER_SIZE];
+  uint16_t size;
+};
+
+// Fixed pool of outgoing frame buffers, so building a frame needs neither the
+// heap nor a full-size frame on the stack.
+class TuyaFramePool {
+public:
+  TuyaFramePool();
+
+  TuyaFrameBuffer* acquire();
+  void release(TuyaFrameBuffer* buffer);
+  uint8_t available() const;
+
+private:
+  TuyaFrameBuffer _buffers[TUYA_FRAME_POOL_SIZE];
+  uint32_t _used;
+};
+
+// FIFO of serialized frames waiting to be written. Its capacity matches the
+// pool, so every buffer taken from the pool always fits.
+class TuyaFrameQueue {
+public:
+  TuyaFrameQueue();
+
+  bool push(TuyaFrameBuffer* buffer);
+  TuyaFrameBuffer* pop();
+  uint8_t size() const;
+
+private:
+  TuyaFrameBuffer* _buffers[TUYA_FRAME_POOL_SIZE];
+  uint8_t _head;
+  uint8_t _count;
+};
+
+#endif // TUYA_FRAME_H
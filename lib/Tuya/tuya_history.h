@@ -0,0 +1,281 @@
+#ifndef TUYA_HISTORY_H
+#define TUYA_HISTORY_H
+
+#include <stdint.h>
+
+#define TUYA_HISTORY_ESCAPE 0x80000000UL
+
+// Time buckets per rollup window, min/max resolution is length / (buckets - 1)
+#ifndef TUYA_HISTORY_BUCKETS
+#define TUYA_HISTORY_BUCKETS 16
+#endif
+
+// Rollup of the samples inside one window, values in the sensor's raw
+// fixed-point units. span is the time from the oldest sample in the rollup
+// to the query.
+struct TuyaHistoryStats {
+  uint32_t count;
+  int32_t min;
+  int32_t max;
+  int64_t sum;
+  int64_t sumSquares;
+  uint32_t span;
+
+  float mean() const {
+    return count > 0 ? (float)sum / count : 0.0f;
+  }
+
+  float variance() const {
+    if (count == 0) {
+      return 0.0f;
+    }
+    float average = mean();
+    return (float)sumSquares / count - average * average;
+  }
+};
+
+// Fixed-memory sample history of one sensor. Samples are stored as deltas to
+// the previous sample, one 32-bit word each (16-bit value delta, 16-bit time
+// delta in ms); larger steps take an escape word plus two full words. The
+// oldest samples are dropped once Capacity words are in use.
+//
+// Windows do not read the stored samples. Each one splits its length into
+// TUYA_HISTORY_BUCKETS - 1 time buckets that keep count, sum, sum of squares,
+// min and max, so stats() costs O(buckets) and a window covers its full
+// length however few samples are stored. The oldest bucket may reach up to
+// one bucket width past the window; stats.span says how far back a rollup
+// actually goes.
+template <uint16_t Capacity, uint8_t Windows>
+class TuyaSensorHistory {
+  static_assert(Capacity >= 4, "history needs room for an escaped sample");
+  static_assert(TUYA_HISTORY_BUCKETS >= 2, "a window needs at least two buckets");
+
+public:
+  TuyaSensorHistory(const uint32_t (&lengths)[Windows]) : _head(0), _used(0), _count(0), _lastTimestamp(0),
+    _lastValue(0), _oldest() {
+    for (uint8_t i = 0; i < Windows; i++) {
+      setLength(_windows[i], lengths[i]);
+    }
+  }
+
+  void add(uint32_t timestamp, int32_t value) {
+    uint32_t timeDelta = timestamp - _lastTimestamp;
+    uint32_t valueDelta = (uint32_t)value - (uint32_t)_lastValue;
+    int32_t shortDelta = (int32_t)valueDelta;
+    bool escape = shortDelta <= INT16_MIN || shortDelta > INT16_MAX || timeDelta > UINT16_MAX;
+    uint8_t words = escape ? 3 : 1;
+
+    while (Capacity - _used < words) {
+      dropOldest();
+    }
+
+    Cursor sample = { _head, words, timestamp, value };
+    if (escape) {
+      put(TUYA_HISTORY_ESCAPE);
+      put(valueDelta);
+      put(timeDelta);
+    } else {
+      put(((uint32_t)(uint16_t)shortDelta << 16) | timeDelta);
+    }
+
+    if (_count == 0) {
+      _oldest = sample;
+    }
+    _count++;
+    _lastTimestamp = timestamp;
+    _lastValue = value;
+
+    for (uint8_t i = 0; i < Windows; i++) {
+      push(_windows[i], timestamp, value);
+    }
+  }
+
+  // Folds the buckets that still overlap the window into one rollup
+  bool stats(uint8_t window, uint32_t now, TuyaHistoryStats& stats) const {
+    stats = {};
+    if (window >= Windows) {
+      return false;
+    }
+
+    const Window& target = _windows[window];
+    for (uint8_t i = 0; i < target.used; i++) {
+      const Bucket& bucket = target.buckets[(target.newest + TUYA_HISTORY_BUCKETS - i) % TUYA_HISTORY_BUCKETS];
+      if ((int32_t)(now - bucket.start) >= (int32_t)(target.length + target.width)) {
+        break;
+      }
+      stats.min = stats.count == 0 || bucket.min < stats.min ? bucket.min : stats.min;
+      stats.max = stats.count == 0 || bucket.max > stats.max ? bucket.max : stats.max;
+      stats.count += bucket.count;
+      stats.sum += bucket.sum;
+      stats.sumSquares += bucket.sumSquares;
+      stats.span = now - bucket.first;
+    }
+    return stats.count > 0;
+  }
+
+  // Changes a window length and rebuilds it from the stored samples, so until
+  // the window has filled again it only reaches back as far as they do
+  bool setWindow(uint8_t window, uint32_t length) {
+    if (window >= Windows || length == 0) {
+      return false;
+    }
+
+    Window& target = _windows[window];
+    setLength(target, length);
+    Cursor sample = _oldest;
+    for (uint16_t i = 0; i < _count; i++) {
+      if (i > 0) {
+        advance(sample);
+      }
+      push(target, sample.timestamp, sample.value);
+    }
+    return true;
+  }
+
+  void clear() {
+    _head = 0;
+    _used = 0;
+    _count = 0;
+    _lastTimestamp = 0;
+    _lastValue = 0;
+    for (uint8_t i = 0; i < Windows; i++) {
+      _windows[i].used = 0;
+    }
+  }
+
+  uint16_t size() const {
+    return _count;
+  }
+
+private:
+  // Decoded sample and the position of its words in the ring
+  struct Cursor {
+    uint16_t position;
+    uint8_t words;
+    uint32_t timestamp;
+    int32_t value;
+  };
+
+  struct Bucket {
+    int64_t sum;
+    int64_t sumSquares;
+    uint32_t start;
+    uint32_t first;
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+  };
+
+  // Ring of buckets, newest is the one samples are added to
+  struct Window {
+    uint32_t length;
+    uint32_t width;
+    uint8_t newest;
+    uint8_t used;
+    Bucket buckets[TUYA_HISTORY_BUCKETS];
+  };
+
+  uint32_t _words[Capacity];
+  uint16_t _head;
+  uint16_t _used;
+  uint16_t _count;
+  uint32_t _lastTimestamp;
+  int32_t _lastValue;
+  Cursor _oldest;
+  Window _windows[Windows];
+
+  void put(uint32_t word) {
+    _words[_head] = word;
+    _head = (_head + 1) % Capacity;
+    _used++;
+  }
+
+  uint32_t wordAt(uint16_t position, uint8_t offset) const {
+    return _words[(position + offset) % Capacity];
+  }
+
+  // Moves a cursor to the next sample by applying its delta
+  void advance(Cursor& sample) const {
+    sample.position = (sample.position + sample.words) % Capacity;
+
+    uint32_t word = _words[sample.position];
+    if (word == TUYA_HISTORY_ESCAPE) {
+      sample.words = 3;
+      sample.value = (int32_t)((uint32_t)sample.value + wordAt(sample.position, 1));
+      sample.timestamp += wordAt(sample.position, 2);
+    } else {
+      sample.words = 1;
+      sample.value = (int32_t)((uint32_t)sample.value + (uint32_t)(int32_t)(int16_t)(word >> 16));
+      sample.timestamp += word & 0xFFFF;
+    }
+  }
+
+  void dropOldest() {
+    _used -= _oldest.words;
+    _count--;
+    if (_count > 0) {
+      advance(_oldest);
+    }
+  }
+
+  // The newest bucket plus the older ones together always span the length
+  static void setLength(Window& window, uint32_t length) {
+    window.length = length;
+    window.width = (length + TUYA_HISTORY_BUCKETS - 2) / (TUYA_HISTORY_BUCKETS - 1);
+    if (window.width == 0) {
+      window.width = 1;
+    }
+    window.newest = 0;
+    window.used = 0;
+  }
+
+  // Buckets are aligned to the first one, a sample past the newest bucket
+  // opens the bucket it falls into and the oldest bucket is reused
+  static void push(Window& window, uint32_t timestamp, int32_t value) {
+    Bucket* bucket = &window.buckets[window.newest];
+    uint32_t age = window.used > 0 ? timestamp - bucket->start : 0;
+    if (window.used == 0 || ((int32_t)age >= 0 && age >= window.width)) {
+      uint32_t start = window.used == 0 ? timestamp : bucket->start + age / window.width * window.width;
+      window.newest = (window.newest + 1) % TUYA_HISTORY_BUCKETS;
+      if (window.used < TUYA_HISTORY_BUCKETS) {
+        window.used++;
+      }
+      bucket = &window.buckets[window.newest];
+      *bucket = { 0, 0, start, timestamp, 0, value, value };
+    }
+
+    bucket->count++;
+    bucket->sum += value;
+    bucket->sumSquares += (int64_t)value * value;
+    bucket->min = value < bucket->min ? value : bucket->min;
+    bucket->max = value > bucket->max ? value : bucket->max;
+  }
+
+public:
+  // Walks the stored samples from oldest to newest
+  class Reader {
+  public:
+    Reader(const TuyaSensorHistory& history) : _history(history), _sample(history._oldest), _remaining(history._count) {
+    }
+
+    bool next(uint32_t& timestamp, int32_t& value) {
+      if (_remaining == 0) {
+        return false;
+      }
+      if (_remaining < _history._count) {
+        _history.advance(_sample);
+      }
+      _remaining--;
+      timestamp = _sample.timestamp;
+      value = _sample.value;
+      return true;
+    }
+
+  private:
+    const TuyaSensorHistory& _history;
+    typename TuyaSensorHistory::Cursor _sample;
+    uint16_t _remaining;
+  };
+};
+
+#endif // TUYA_HISTORY_H
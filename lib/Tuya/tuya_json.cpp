@@ -0,0 +1,219 @@
+#include "tuya_json.h"
+
+bool TuyaJsonField::is(const char* name) const {
+  size_t length = strlen(name);
+  return length == keyLength && memcmp(key, name, length) == 0;
+}
+
+// Unescapes a string value into out, truncating it to size - 1 characters.
+// \uXXXX escapes outside ASCII become '?'. Returns the copied length.
+size_t TuyaJsonField::copyString(char* out, size_t size) const {
+  if (size == 0) {
+    return 0;
+  }
+
+  size_t written = 0;
+  for (uint16_t i = 0; i < valueLength && written + 1 < size; i++) {
+    char c = value[i];
+    if (c == '\\' && i + 1 < valueLength) {
+      c = value[++i];
+      switch (c) {
+      case 'b':
+        c = '\b';
+        break;
+      case 'f':
+        c = '\f';
+        break;
+      case 'n':
+        c = '\n';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'u': {
+        uint16_t code = 0;
+        uint8_t digits = 0;
+        while (digits < 4 && i + 1 < valueLength && isxdigit((unsigned char)value[i + 1])) {
+          char digit = value[++i];
+          code = (code << 4) | (isdigit((unsigned char)digit) ? digit - '0' : (tolower(digit) - 'a' + 10));
+          digits++;
+        }
+        c = code < 0x80 ? (char)code : '?';
+        break;
+      }
+      default:
+        break;
+      }
+    }
+    out[written++] = c;
+  }
+  out[written] = '\0';
+  return written;
+}
+
+// Integer part of a number, or of a string holding one
+bool TuyaJsonField::toInteger(int32_t& result) const {
+  if (type != JSON_NUMBER && type != JSON_STRING) {
+    return false;
+  }
+
+  uint16_t i = 0;
+  bool negative = i < valueLength && value[i] == '-';
+  if (negative) {
+    i++;
+  }
+  if (i >= valueLength || !isdigit((unsigned char)value[i])) {
+    return false;
+  }
+
+  int64_t number = 0;
+  while (i < valueLength && isdigit((unsigned char)value[i])) {
+    number = number * 10 + (value[i++] - '0');
+    if (number > INT32_MAX) {
+      return false;
+    }
+  }
+  result = negative ? -number : number;
+  return true;
+}
+
+TuyaJsonScanner::TuyaJsonScanner(const uint8_t* data, uint16_t length)
+  : _data(reinterpret_cast<const char*>(data)), _length(data != nullptr ? length : 0), _position(0),
+    _started(false), _complete(false), _failed(false) {
+}
+
+bool TuyaJsonScanner::next(TuyaJsonField& field) {
+  if (_complete || _failed) {
+    return false;
+  }
+
+  skipSpace();
+  if (!_started) {
+    if (!consume('{')) {
+      return fail();
+    }
+    _started = true;
+    skipSpace();
+    if (consume('}')) {
+      _complete = true;
+      return false;
+    }
+  } else if (consume('}')) {
+    _complete = true;
+    return false;
+  } else if (!consume(',')) {
+    return fail();
+  }
+
+  skipSpace();
+  if (!scanString(field.key, field.keyLength)) {
+    return fail();
+  }
+  skipSpace();
+  if (!consume(':')) {
+    return fail();
+  }
+  skipSpace();
+  if (!scanValue(field)) {
+    return fail();
+  }
+  skipSpace();
+  return true;
+}
+
+bool TuyaJsonScanner::complete() const {
+  return _complete;
+}
+
+void TuyaJsonScanner::skipSpace() {
+  while (_position < _length && isspace((unsigned char)_data[_position])) {
+    _position++;
+  }
+}
+
+bool TuyaJsonScanner::consume(char expected) {
+  if (_position < _length && _data[_position] == expected) {
+    _position++;
+    return true;
+  }
+  return false;
+}
+
+bool TuyaJsonScanner::scanString(const char*& start, uint16_t& length) {
+  if (!consume('"')) {
+    return false;
+  }
+
+  uint16_t begin = _position;
+  while (_position < _length) {
+    char c = _data[_position];
+    if (c == '"') {
+      start = _data + begin;
+      length = _position - begin;
+      _position++;
+      return true;
+    }
+    _position += c == '\\' ? 2 : 1;
+  }
+  return false;
+}
+
+// Nested objects and arrays are skipped by bracket depth, strings inside
+// them included
+bool TuyaJsonScanner::scanValue(TuyaJsonField& field) {
+  if (_position >= _length) {
+    return false;
+  }
+
+  char c = _data[_position];
+  if (c == '"') {
+    field.type = JSON_STRING;
+    return scanString(field.value, field.valueLength);
+  }
+
+  uint16_t begin = _position;
+  if (c == '{' || c == '[') {
+    field.type = c == '{' ? JSON_OBJECT : JSON_ARRAY;
+    uint16_t depth = 0;
+    while (_position < _length) {
+      c = _data[_position];
+      if (c == '"') {
+        const char* start;
+        uint16_t length;
+        if (!scanString(start, length)) {
+          return false;
+        }
+        continue;
+      }
+      _position++;
+      if (c == '{' || c == '[') {
+        depth++;
+      } else if ((c == '}' || c == ']') && --depth == 0) {
+        field.value = _data + begin;
+        field.valueLength = _position - begin;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  field.type = c == '-' || isdigit((unsigned char)c) ? JSON_NUMBER : JSON_LITERAL;
+  while (_position < _length) {
+    c = _data[_position];
+    if (c == ',' || c == '}' || c == ']' || isspace((unsigned char)c)) {
+      break;
+    }
+    _position++;
+  }
+  field.value = _data + begin;
+  field.valueLength = _position - begin;
+  return field.valueLength > 0;
+}
+
+bool TuyaJsonScanner::fail() {
+  _failed = true;
+  return false;
+}
@@ -0,0 +1,54 @@
+#ifndef TUYA_JSON_H
+#define TUYA_JSON_H
+
+#include <Arduino.h>
+
+enum TuyaJsonType {
+  JSON_STRING,
+  JSON_NUMBER,
+  JSON_LITERAL,
+  JSON_OBJECT,
+  JSON_ARRAY,
+};
+
+// One member of the scanned object. key and value point into the scanned
+// bytes; a string value excludes its quotes and is still escaped.
+struct TuyaJsonField {
+  const char* key;
+  uint16_t keyLength;
+  const char* value;
+  uint16_t valueLength;
+  TuyaJsonType type;
+
+  bool is(const char* name) const;
+  size_t copyString(char* out, size_t size) const;
+  bool toInteger(int32_t& result) const;
+};
+
+// In-place scanner for the members of a flat JSON object, such as the
+// product info payload. Nothing is copied or allocated: next() walks one
+// member at a time and skips nested values whole. complete() tells whether
+// the object was well formed up to its closing brace.
+class TuyaJsonScanner {
+public:
+  TuyaJsonScanner(const uint8_t* data, uint16_t length);
+
+  bool next(TuyaJsonField& field);
+  bool complete() const;
+
+private:
+  const char* _data;
+  uint16_t _length;
+  uint16_t _position;
+  bool _started;
+  bool _complete;
+  bool _failed;
+
+  void skipSpace();
+  bool consume(char expected);
+  bool scanString(const char*& start, uint16_t& length);
+  bool scanValue(TuyaJsonField& field);
+  bool fail();
+};
+
+#endif // TUYA_JSON_H
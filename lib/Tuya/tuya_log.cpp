@@ -0,0 +1,145 @@
+#include "tuya_log.h"
+#include "tuya_frame.h"
+
+TuyaLog::TuyaLog() : _pOutput(nullptr), _dropped(0) {
+}
+
+void TuyaLog::setOutput(Print* output) {
+  _pOutput = output;
+}
+
+// Formats up to maxRecords pending records and returns how many it printed
+size_t TuyaLog::flush(size_t maxRecords) {
+  size_t printed = 0;
+  uint8_t header[TUYA_LOG_HEADER_SIZE];
+  uint8_t payload[UINT8_MAX];
+
+  while (printed < maxRecords && _ring.available() >= TUYA_LOG_HEADER_SIZE) {
+    _ring.read(header, sizeof(header));
+    _ring.read(payload, header[0]);
+    if (_pOutput != nullptr) {
+      printRecord(header, payload);
+    }
+    printed++;
+  }
+  return printed;
+}
+
+TuyaLog& tuyaDefaultLog() {
+  static TuyaLog log;
+  return log;
+}
+
+uint32_t TuyaLog::dropped() const {
+  return _dropped.load(std::memory_order_relaxed);
+}
+
+void TuyaLog::appendMessage(uint8_t source, TuyaLogLevel level, const char* text) {
+  append(source, level, LOG_MESSAGE, reinterpret_cast<const uint8_t*>(&text), sizeof(text));
+}
+
+void TuyaLog::appendValue(uint8_t source, TuyaLogLevel level, const char* text, int32_t value) {
+  uint8_t payload[sizeof(text) + sizeof(value)];
+  memcpy(payload, &text, sizeof(text));
+  memcpy(payload + sizeof(text), &value, sizeof(value));
+  append(source, level, LOG_VALUE, payload, sizeof(payload));
+}
+
+// Keeps the header fields, the checksum and the first payload bytes
+void TuyaLog::appendFrame(uint8_t source, TuyaLogEvent direction, const uint8_t* bytes, uint16_t size) {
+  if (size < TUYA_HEADER_SIZE + 1) {
+    return;
+  }
+
+  uint16_t dataLength = size - TUYA_HEADER_SIZE - 1;
+  uint8_t kept = dataLength < TUYA_LOG_FRAME_BYTES ? dataLength : TUYA_LOG_FRAME_BYTES;
+  uint8_t payload[5 + TUYA_LOG_FRAME_BYTES];
+  payload[0] = bytes[2];
+  payload[1] = bytes[3];
+  payload[2] = bytes[4];
+  payload[3] = bytes[5];
+  payload[4] = bytes[size - 1];
+  memcpy(payload + 5, bytes + TUYA_HEADER_SIZE, kept);
+  append(source, LOG_DEBUG, direction, payload, 5 + kept);
+}
+
+void TuyaLog::append(uint8_t source, TuyaLogLevel level, TuyaLogEvent event, const uint8_t* payload, uint8_t length) {
+  uint8_t record[TUYA_LOG_HEADER_SIZE + UINT8_MAX];
+  if (TUYA_LOG_BUFFER_SIZE - _ring.available() < TUYA_LOG_HEADER_SIZE + (size_t)length) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  uint32_t timestamp = millis();
+  record[0] = length;
+  record[1] = level;
+  record[2] = event;
+  record[3] = source;
+  record[4] = timestamp & 0xFF;
+  record[5] = (timestamp >> 8) & 0xFF;
+  record[6] = (timestamp >> 16) & 0xFF;
+  record[7] = (timestamp >> 24) & 0xFF;
+  memcpy(record + TUYA_LOG_HEADER_SIZE, payload, length);
+  _ring.write(record, TUYA_LOG_HEADER_SIZE + length);
+}
+
+void TuyaLog::printRecord(const uint8_t* header, const uint8_t* payload) {
+  static const char levels[] = { '-', 'E', 'W', 'I', 'D' };
+  uint8_t length = header[0];
+  uint8_t level = header[1];
+  uint8_t event = header[2];
+  uint8_t source = header[3];
+  uint32_t timestamp = header[4] | (header[5] << 8) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 24);
+
+  _pOutput->print("[");
+  _pOutput->print((unsigned long)timestamp);
+  _pOutput->print("] ");
+  _pOutput->print(level < sizeof(levels) ? levels[level] : '?');
+  _pOutput->print(" ");
+  if (source != TUYA_LOG_NO_SOURCE) {
+    _pOutput->print("#");
+    _pOutput->print(source);
+    _pOutput->print(" ");
+  }
+
+  const char* text;
+  switch (event) {
+  case LOG_MESSAGE:
+    memcpy(&text, payload, sizeof(text));
+    _pOutput->println(text);
+    break;
+  case LOG_VALUE: {
+    int32_t value;
+    memcpy(&text, payload, sizeof(text));
+    memcpy(&value, payload + sizeof(text), sizeof(value));
+    _pOutput->print(text);
+    _pOutput->println((long)value);
+    break;
+  }
+  case LOG_FRAME_RX:
+  case LOG_FRAME_TX: {
+    uint16_t dataLength = (payload[2] << 8) | payload[3];
+    _pOutput->print(event == LOG_FRAME_RX ? "Received frame: " : "Sent frame: ");
+    _pOutput->print("version: ");
+    _pOutput->print(payload[0], HEX);
+    _pOutput->print(", command: ");
+    _pOutput->print(payload[1], HEX);
+    _pOutput->print(", length: ");
+    _pOutput->print(dataLength, HEX);
+    _pOutput->print(", data: ");
+    for (uint8_t i = 5; i < length; i++) {
+      _pOutput->print(payload[i], HEX);
+      _pOutput->print(" ");
+    }
+    if (dataLength > length - 5) {
+      _pOutput->print("... ");
+    }
+    _pOutput->print(", checksum: ");
+    _pOutput->println(payload[4], HEX);
+    break;
+  }
+  default:
+    _pOutput->println("?");
+    break;
+  }
+}
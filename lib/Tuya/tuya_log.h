@@ -0,0 +1,125 @@
+#ifndef TUYA_LOG_H
+#define TUYA_LOG_H
+
+#include <Arduino.h>
+#include <Print.h>
+#include "tuya_spsc_ring.h"
+
+#define TUYA_LOG_LEVEL_NONE 0
+#define TUYA_LOG_LEVEL_ERROR 1
+#define TUYA_LOG_LEVEL_WARN 2
+#define TUYA_LOG_LEVEL_INFO 3
+#define TUYA_LOG_LEVEL_DEBUG 4
+
+// Levels above this are compiled out, calls to them cost nothing
+#ifndef TUYA_LOG_LEVEL
+#define TUYA_LOG_LEVEL TUYA_LOG_LEVEL_DEBUG
+#endif
+
+#ifndef TUYA_LOG_BUFFER_SIZE
+#define TUYA_LOG_BUFFER_SIZE 1024
+#endif
+
+// Records Tuya::loop() formats per pass when it flushes the log itself
+#ifndef TUYA_LOG_FLUSH_RECORDS
+#define TUYA_LOG_FLUSH_RECORDS 4
+#endif
+
+// Payload bytes kept by a frame record, the rest is only counted
+#define TUYA_LOG_FRAME_BYTES 16
+#define TUYA_LOG_HEADER_SIZE 8
+
+// Source of records that are not tagged with a device id
+#define TUYA_LOG_NO_SOURCE 0xFF
+
+enum TuyaLogLevel {
+  LOG_ERROR = TUYA_LOG_LEVEL_ERROR,
+  LOG_WARN = TUYA_LOG_LEVEL_WARN,
+  LOG_INFO = TUYA_LOG_LEVEL_INFO,
+  LOG_DEBUG = TUYA_LOG_LEVEL_DEBUG,
+};
+
+enum TuyaLogEvent {
+  LOG_MESSAGE = 0x00,
+  LOG_VALUE = 0x01,
+  LOG_FRAME_RX = 0x02,
+  LOG_FRAME_TX = 0x03,
+};
+
+// Deferred logger. The hot path only appends a small binary record (level,
+// event, millis() and a payload) to a lock-free ring; flush() turns records
+// into text later, from an idle point in loop() or from a low-priority task.
+// Messages must be string literals since only their address is recorded.
+// A record that does not fit is dropped and counted instead of blocking.
+// Every record carries a source byte so devices can share one log.
+class TuyaLog {
+public:
+  TuyaLog();
+
+  void setOutput(Print* output);
+  bool enabled() const {
+    return _pOutput != nullptr;
+  }
+
+  void error(uint8_t source, const char* text) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_ERROR && enabled()) {
+      appendMessage(source, LOG_ERROR, text);
+    }
+  }
+
+  void warn(uint8_t source, const char* text) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_WARN && enabled()) {
+      appendMessage(source, LOG_WARN, text);
+    }
+  }
+
+  void warn(uint8_t source, const char* text, int32_t value) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_WARN && enabled()) {
+      appendValue(source, LOG_WARN, text, value);
+    }
+  }
+
+  void info(uint8_t source, const char* text) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_INFO && enabled()) {
+      appendMessage(source, LOG_INFO, text);
+    }
+  }
+
+  void debug(uint8_t source, const char* text) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_DEBUG && enabled()) {
+      appendMessage(source, LOG_DEBUG, text);
+    }
+  }
+
+  void debug(uint8_t source, const char* text, int32_t value) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_DEBUG && enabled()) {
+      appendValue(source, LOG_DEBUG, text, value);
+    }
+  }
+
+  void frame(uint8_t source, TuyaLogEvent direction, const uint8_t* bytes, uint16_t size) {
+    if (TUYA_LOG_LEVEL >= TUYA_LOG_LEVEL_DEBUG && enabled()) {
+      appendFrame(source, direction, bytes, size);
+    }
+  }
+
+  size_t flush(size_t maxRecords = SIZE_MAX);
+  uint32_t dropped() const;
+
+private:
+  TuyaSpscRing<TUYA_LOG_BUFFER_SIZE> _ring;
+  Print* _pOutput;
+  std::atomic<uint32_t> _dropped;
+
+  void appendMessage(uint8_t source, TuyaLogLevel level, const char* text);
+  void appendValue(uint8_t source, TuyaLogLevel level, const char* text, int32_t value);
+  void appendFrame(uint8_t source, TuyaLogEvent direction, const uint8_t* bytes, uint16_t size);
+  void append(uint8_t source, TuyaLogLevel level, TuyaLogEvent event, const uint8_t* payload, uint8_t length);
+  void printRecord(const uint8_t* header, const uint8_t* payload);
+};
+
+// Log shared by every device that was not given its own with Tuya::setLog().
+// Like any TuyaLog it takes records from one thread only.
+TuyaLog& tuyaDefaultLog();
+
+#endif // TUYA_LOG_H
@@ -0,0 +1,31 @@
+#include "tuya_nvs_store.h"
+
+#if defined(ESP32)
+
+TuyaNvsStore::TuyaNvsStore(const char* name, const char* key) : _name(name), _key(key) {
+}
+
+size_t TuyaNvsStore::load(uint8_t* data, size_t size) {
+  if (!_preferences.begin(_name, true)) {
+    return 0;
+  }
+  size_t length = _preferences.getBytesLength(_key);
+  if (length > size) {
+    length = 0;
+  } else if (length > 0) {
+    length = _preferences.getBytes(_key, data, length);
+  }
+  _preferences.end();
+  return length;
+}
+
+bool TuyaNvsStore::save(const uint8_t* data, size_t length) {
+  if (!_preferences.begin(_name, false)) {
+    return false;
+  }
+  bool saved = _preferences.putBytes(_key, data, length) == length;
+  _preferences.end();
+  return saved;
+}
+
+#endif // ESP32
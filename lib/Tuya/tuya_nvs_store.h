@@ -0,0 +1,27 @@
+#ifndef TUYA_NVS_STORE_H
+#define TUYA_NVS_STORE_H
+
+#if defined(ESP32)
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "tuya_snapshot.h"
+
+// Snapshot kept as one NVS blob. NVS spreads writes over its pages, and
+// Tuya::persist() already limits how often they happen.
+class TuyaNvsStore : public TuyaStateStore {
+public:
+  TuyaNvsStore(const char* name = "tuya", const char* key = "state");
+
+  size_t load(uint8_t* data, size_t size) override;
+  bool save(const uint8_t* data, size_t length) override;
+
+private:
+  const char* _name;
+  const char* _key;
+  Preferences _preferences;
+};
+
+#endif // ESP32
+
+#endif // TUYA_NVS_STORE_H
@@ -0,0 +1,158 @@
+#include "tuya_parser.h"
+
+TuyaFrameParser::TuyaFrameParser() : _skipped(0), _timestamp(0), _startedAt(0) {
+  reset();
+}
+
+void TuyaFrameParser::reset() {
+  _length = 0;
+  _read = 0;
+  _end = 0;
+  _dataLength = 0;
+  _sum = 0;
+  _complete = false;
+  _state = PARSE_HEADER_HIGH;
+}
+
+TuyaErrorTransmission TuyaFrameParser::push(uint8_t byte) {
+  release();
+  if (_end >= sizeof(_buffer)) {
+    reset();
+    return ERROR_OVERFLOW;
+  }
+  _buffer[_end++] = byte;
+  return poll();
+}
+
+// Tags the byte with its arrival time; a frame keeps the time of the byte
+// its header started with. Rescanned bytes take the latest time.
+TuyaErrorTransmission TuyaFrameParser::push(uint8_t byte, uint32_t timestamp) {
+  _timestamp = timestamp;
+  return push(byte);
+}
+
+TuyaErrorTransmission TuyaFrameParser::poll() {
+  release();
+  while (_read < _end) {
+    TuyaErrorTransmission result = consume(_buffer[_read++]);
+    if (result != ERROR_NO_DATA) {
+      return result;
+    }
+  }
+  _read = _length;
+  _end = _length;
+  return ERROR_NO_DATA;
+}
+
+const uint8_t* TuyaFrameParser::frame() const {
+  return _buffer;
+}
+
+uint16_t TuyaFrameParser::frameSize() const {
+  return _complete ? _length : 0;
+}
+
+// Bytes dropped while hunting for a 0x55 0xAA header, rescanned bytes included
+uint32_t TuyaFrameParser::skipped() const {
+  return _skipped;
+}
+
+void TuyaFrameParser::clearSkipped() {
+  _skipped = 0;
+}
+
+TuyaFrameView TuyaFrameParser::view() const {
+  uint16_t length = (_buffer[4] << 8) | _buffer[5];
+  return {
+    .version = _buffer[2],
+    .command = _buffer[3],
+    .length = length,
+    .data = _buffer + TUYA_HEADER_SIZE,
+    .checksum = _buffer[TUYA_HEADER_SIZE + length],
+    .timestamp = _startedAt,
+  };
+}
+
+void TuyaFrameParser::release() {
+  if (!_complete) {
+    return;
+  }
+  _complete = false;
+  _length = 0;
+  if (_read == _end) {
+    _read = 0;
+    _end = 0;
+  }
+}
+
+TuyaErrorTransmission TuyaFrameParser::consume(uint8_t byte) {
+  switch (_state) {
+  case PARSE_HEADER_HIGH:
+    if (byte == 0x55) {
+      _buffer[0] = byte;
+      _length = 1;
+      _startedAt = _timestamp;
+      _state = PARSE_HEADER_LOW;
+    } else {
+      _skipped++;
+    }
+    return ERROR_NO_DATA;
+  case PARSE_HEADER_LOW:
+    if (byte == 0xAA) {
+      _buffer[_length++] = byte;
+      _sum = 0x55 + 0xAA;
+      _state = PARSE_VERSION;
+    } else if (byte == 0x55) {
+      _skipped++;
+    } else {
+      _skipped += 2;
+      _length = 0;
+      _state = PARSE_HEADER_HIGH;
+    }
+    return ERROR_NO_DATA;
+  case PARSE_VERSION:
+  case PARSE_COMMAND:
+  case PARSE_LENGTH_HIGH:
+    _buffer[_length++] = byte;
+    _sum += byte;
+    _state = static_cast<TuyaParserState>(_state + 1);
+    return ERROR_NO_DATA;
+  case PARSE_LENGTH_LOW:
+    _buffer[_length++] = byte;
+    _sum += byte;
+    _dataLength = (_buffer[4] << 8) | _buffer[5];
+    if (_dataLength > TUYA_MAX_DATA_LENGTH) {
+      return resync(ERROR_OVERFLOW);
+    }
+    _state = _dataLength > 0 ? PARSE_DATA : PARSE_CHECKSUM;
+    return ERROR_NO_DATA;
+  case PARSE_DATA:
+    _buffer[_length++] = byte;
+    _sum += byte;
+    if (_length == TUYA_HEADER_SIZE + _dataLength) {
+      _state = PARSE_CHECKSUM;
+    }
+    return ERROR_NO_DATA;
+  case PARSE_CHECKSUM:
+    _buffer[_length++] = byte;
+    if (byte != _sum) {
+      return resync(ERROR_CHECKSUM);
+    }
+    _complete = true;
+    _state = PARSE_HEADER_HIGH;
+    return ERROR_NONE;
+  }
+  return ERROR_NO_DATA;
+}
+
+TuyaErrorTransmission TuyaFrameParser::resync(TuyaErrorTransmission error) {
+  // Move the unread bytes right behind the rejected frame, then rescan
+  // everything after its first header byte.
+  uint16_t pending = _end - _read;
+  memmove(_buffer + _length, _buffer + _read, pending);
+  _end = _length + pending;
+  _read = 1;
+  _length = 0;
+  _state = PARSE_HEADER_HIGH;
+  return error;
+}
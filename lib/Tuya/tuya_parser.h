@@ -0,0 +1,64 @@
+#ifndef TUYA_PARSER_H
+#define TUYA_PARSER_H
+
+#include <Arduino.h>
+#include "tuya_frame.h"
+
+// Enums for parser results and states
+enum TuyaErrorTransmission {
+  ERROR_NONE = 0,
+  ERROR_NO_DATA,
+  ERROR_CHECKSUM,
+  ERROR_OVERFLOW,
+};
+
+enum TuyaParserState {
+  PARSE_HEADER_HIGH = 0,
+  PARSE_HEADER_LOW,
+  PARSE_VERSION,
+  PARSE_COMMAND,
+  PARSE_LENGTH_HIGH,
+  PARSE_LENGTH_LOW,
+  PARSE_DATA,
+  PARSE_CHECKSUM,
+};
+
+// Incremental frame parser. Bytes are pushed one at a time as they arrive and
+// the parser keeps its state between calls, so a frame may be split across any
+// number of loop() passes. On a checksum or length error the buffered bytes are
+// rescanned for the next 0x55 0xAA header instead of being discarded.
+class TuyaFrameParser {
+public:
+  TuyaFrameParser();
+
+  TuyaErrorTransmission push(uint8_t byte);
+  TuyaErrorTransmission push(uint8_t byte, uint32_t timestamp);
+  TuyaErrorTransmission poll();
+  void reset();
+
+  const uint8_t* frame() const;
+  uint16_t frameSize() const;
+  TuyaFrameView view() const;
+
+  uint32_t skipped() const;
+  void clearSkipped();
+
+private:
+  uint8_t _buffer[TUYA_MAX_FRAME_SIZE];
+  uint16_t _length;
+  uint16_t _read;
+  uint16_t _end;
+  uint16_t _dataLength;
+  uint8_t _sum;
+  bool _complete;
+  TuyaParserState _state;
+  uint32_t _skipped;
+  uint32_t _timestamp;
+  uint32_t _startedAt;
+
+  void release();
+  TuyaErrorTransmission consume(uint8_t byte);
+  TuyaErrorTransmission resync(TuyaErrorTransmission error);
+};
+
+#endif // TUYA_PARSER_H
@@ -0,0 +1,124 @@
+#include "tuya_request.h"
+
+TuyaRequestTracker::TuyaRequestTracker(TuyaRequestSender sender, void* context)
+  : _sender(sender), _senderContext(context) {
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    _requests[i] = { nullptr, nullptr, 0, 0, 0, 0, 0, false };
+  }
+}
+
+bool TuyaRequestTracker::start(uint8_t command, uint32_t timeout, uint8_t maxAttempts,
+  TuyaRequestCallback callback, void* context) {
+  if (find(command) != nullptr) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    if (!_requests[i].active) {
+      _requests[i] = { callback, context, timeout, (uint32_t)(millis() + timeout), command, 1, maxAttempts, true };
+      _sender(command, _senderContext);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TuyaRequestTracker::complete(uint8_t command) {
+  TuyaRequest* request = find(command);
+  if (request == nullptr) {
+    return false;
+  }
+  finish(*request, REQUEST_COMPLETED);
+  return true;
+}
+
+void TuyaRequestTracker::cancel(uint8_t command) {
+  TuyaRequest* request = find(command);
+  if (request != nullptr) {
+    finish(*request, REQUEST_CANCELLED);
+  }
+}
+
+void TuyaRequestTracker::clear() {
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    if (_requests[i].active) {
+      finish(_requests[i], REQUEST_CANCELLED);
+    }
+  }
+}
+
+bool TuyaRequestTracker::pending(uint8_t command) const {
+  return find(command) != nullptr;
+}
+
+uint8_t TuyaRequestTracker::attempts(uint8_t command) const {
+  const TuyaRequest* request = find(command);
+  return request != nullptr ? request->attempts : 0;
+}
+
+bool TuyaRequestTracker::run(uint32_t now) {
+  bool sent = false;
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    TuyaRequest& request = _requests[i];
+    if (!request.active || (int32_t)(now - request.due) < 0) {
+      continue;
+    }
+
+    if (request.maxAttempts != TUYA_REQUEST_RETRY_FOREVER && request.attempts >= request.maxAttempts) {
+      finish(request, REQUEST_TIMEOUT);
+      continue;
+    }
+
+    request.timeout = request.timeout < TUYA_REQUEST_MAX_TIMEOUT / 2 ? request.timeout * 2 : TUYA_REQUEST_MAX_TIMEOUT;
+    request.due = now + request.timeout;
+    if (request.attempts < UINT8_MAX) {
+      request.attempts++;
+    }
+    _sender(request.command, _senderContext);
+    sent = true;
+  }
+  return sent;
+}
+
+uint32_t TuyaRequestTracker::timeUntilNext(uint32_t now) const {
+  uint32_t next = UINT32_MAX;
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    if (!_requests[i].active) {
+      continue;
+    }
+    int32_t remaining = (int32_t)(_requests[i].due - now);
+    if (remaining <= 0) {
+      return 0;
+    }
+    if ((uint32_t)remaining < next) {
+      next = remaining;
+    }
+  }
+  return next;
+}
+
+TuyaRequest* TuyaRequestTracker::find(uint8_t command) {
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    if (_requests[i].active && _requests[i].command == command) {
+      return &_requests[i];
+    }
+  }
+  return nullptr;
+}
+
+const TuyaRequest* TuyaRequestTracker::find(uint8_t command) const {
+  for (uint8_t i = 0; i < TUYA_MAX_REQUESTS; i++) {
+    if (_requests[i].active && _requests[i].command == command) {
+      return &_requests[i];
+    }
+  }
+  return nullptr;
+}
+
+void TuyaRequestTracker::finish(TuyaRequest& request, TuyaRequestResult result) {
+  // Free the slot first so the callback may start a new request
+  request.active = false;
+  if (request.callback != nullptr) {
+    request.callback(request.command, result, request.context);
+  }
+}
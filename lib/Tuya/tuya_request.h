@@ -0,0 +1,62 @@
+#ifndef TUYA_REQUEST_H
+#define TUYA_REQUEST_H
+
+#include <Arduino.h>
+
+#define TUYA_MAX_REQUESTS 4
+#define TUYA_REQUEST_MAX_TIMEOUT 8000
+#define TUYA_REQUEST_RETRY_FOREVER 0
+
+enum TuyaRequestResult {
+  REQUEST_COMPLETED,
+  REQUEST_TIMEOUT,
+  REQUEST_CANCELLED,
+};
+
+typedef void (*TuyaRequestCallback)(uint8_t command, TuyaRequestResult result, void* context);
+typedef void (*TuyaRequestSender)(uint8_t command, void* context);
+
+// Structs for outstanding requests
+struct TuyaRequest {
+  TuyaRequestCallback callback;
+  void* context;
+  uint32_t timeout;
+  uint32_t due;
+  uint8_t command;
+  uint8_t attempts;
+  uint8_t maxAttempts;
+  bool active;
+};
+
+// Table of commands waiting for a reply, at most one per command byte.
+// start() sends the command once; run() resends it only when the timeout
+// expires, doubling the timeout on every retry up to TUYA_REQUEST_MAX_TIMEOUT.
+// The callback fires once, when the request completes, times out for good
+// or is cancelled.
+class TuyaRequestTracker {
+public:
+  TuyaRequestTracker(TuyaRequestSender sender, void* context);
+
+  bool start(uint8_t command, uint32_t timeout, uint8_t maxAttempts = TUYA_REQUEST_RETRY_FOREVER,
+    TuyaRequestCallback callback = nullptr, void* context = nullptr);
+  bool complete(uint8_t command);
+  void cancel(uint8_t command);
+  void clear();
+
+  bool pending(uint8_t command) const;
+  uint8_t attempts(uint8_t command) const;
+
+  bool run(uint32_t now);
+  uint32_t timeUntilNext(uint32_t now) const;
+
+private:
+  TuyaRequestSender _sender;
+  void* _senderContext;
+  TuyaRequest _requests[TUYA_MAX_REQUESTS];
+
+  TuyaRequest* find(uint8_t command);
+  const TuyaRequest* find(uint8_t command) const;
+  void finish(TuyaRequest& request, TuyaRequestResult result);
+};
+
+#endif // TUYA_REQUEST_H
@@ -0,0 +1,98 @@
+#include "tuya_round_trip.h"
+#include "tuya.h"
+
+struct TuyaRoundTripPair {
+  uint8_t sender;
+  uint8_t request;
+  uint8_t response;
+};
+
+// Commands answered by the other side. The module's writes and DP queries
+// are answered with a status report, the MCU's synchronous report with an ack.
+static const TuyaRoundTripPair roundTripPairs[] = {
+  { MODULE, HEARTBEATS, HEARTBEATS },
+  { MODULE, QUERY_PRODUCT_INFO, QUERY_PRODUCT_INFO },
+  { MODULE, QUERY_WORKING_MODE, QUERY_WORKING_MODE },
+  { MODULE, REPORT_NETWORK_STATUS, REPORT_NETWORK_STATUS },
+  { MODULE, SEND_COMMAND, REPORT_STATUS_ASYNC },
+  { MODULE, QUERY_DP_STATUS, REPORT_STATUS_ASYNC },
+  { MODULE, START_OTA, START_OTA },
+  { MODULE, TRANSMIT_OTA_DATA, TRANSMIT_OTA_DATA },
+  { MCU, RESET_WIFI, RESET_WIFI },
+  { MCU, RESET_WIFI_PAIR_MODE, RESET_WIFI_PAIR_MODE },
+  { MCU, GET_GMT_TIME, GET_GMT_TIME },
+  { MCU, TEST_WIFI_SCANNING, TEST_WIFI_SCANNING },
+  { MCU, GET_MODULE_MEMORY, GET_MODULE_MEMORY },
+  { MCU, GET_LOCAL_TIME, GET_LOCAL_TIME },
+  { MCU, REPORT_STATUS_SYNC, RESPONSE_STATUS_SYNC },
+  { MCU, GET_WIFI_SIGNAL_STRENGTH, GET_WIFI_SIGNAL_STRENGTH },
+  { MCU, GET_CURRENT_NETWORK_STATUS, GET_CURRENT_NETWORK_STATUS },
+  { MCU, GET_MODULE_MAC_ADDRESS, GET_MODULE_MAC_ADDRESS },
+};
+
+TuyaRoundTripTracker::TuyaRoundTripTracker() : _stats(), _sentAt(), _pending(0) {
+}
+
+void TuyaRoundTripTracker::observe(uint8_t sender, uint8_t command, uint32_t timestamp) {
+  expire(timestamp);
+
+  // A response first: both SEND_COMMAND and QUERY_DP_STATUS may wait on the
+  // same report, the oldest one gets it
+  const TuyaRoundTripPair* answered = nullptr;
+  for (const TuyaRoundTripPair& pair : roundTripPairs) {
+    if (pair.sender == sender || pair.response != command || !(_pending & (1ULL << pair.request))) {
+      continue;
+    }
+    if (answered == nullptr || (int32_t)(_sentAt[pair.request] - _sentAt[answered->request]) < 0) {
+      answered = &pair;
+    }
+  }
+  if (answered != nullptr) {
+    _pending &= ~(1ULL << answered->request);
+    _stats.latency[answered->request].add(timestamp - _sentAt[answered->request]);
+    return;
+  }
+
+  for (const TuyaRoundTripPair& pair : roundTripPairs) {
+    if (pair.sender != sender || pair.request != command) {
+      continue;
+    }
+    // A repeated request means the previous one went unanswered
+    if (_pending & (1ULL << pair.request)) {
+      _stats.unanswered[pair.request]++;
+    }
+    _pending |= 1ULL << pair.request;
+    _sentAt[pair.request] = timestamp;
+    return;
+  }
+}
+
+bool TuyaRoundTripTracker::isRequest(uint8_t sender, uint8_t command) const {
+  for (const TuyaRoundTripPair& pair : roundTripPairs) {
+    if (pair.sender == sender && pair.request == command) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const TuyaRoundTripStats& TuyaRoundTripTracker::stats() const {
+  return _stats;
+}
+
+void TuyaRoundTripTracker::reset() {
+  _stats = {};
+  _pending = 0;
+}
+
+void TuyaRoundTripTracker::expire(uint32_t timestamp) {
+  uint64_t pending = _pending;
+  while (pending != 0) {
+    uint8_t slot = __builtin_ctzll(pending);
+    pending &= pending - 1;
+    if (timestamp - _sentAt[slot] > TUYA_ROUND_TRIP_TIMEOUT * 1000UL) {
+      _pending &= ~(1ULL << slot);
+      _stats.unanswered[slot]++;
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef TUYA_ROUND_TRIP_H
+#define TUYA_ROUND_TRIP_H
+
+#include <Arduino.h>
+#include "tuya_stats.h"
+
+// A request older than this many ms is counted as unanswered
+#ifndef TUYA_ROUND_TRIP_TIMEOUT
+#define TUYA_ROUND_TRIP_TIMEOUT 5000
+#endif
+
+// Round-trip latency per request command in µs, between the arrival times
+// of the request and its response. Commands at or above TUYA_STATS_COMMANDS
+// share the last slot.
+struct TuyaRoundTripStats {
+  TuyaHistogram latency[TUYA_STATS_COMMANDS];
+  uint32_t unanswered[TUYA_STATS_COMMANDS];
+};
+
+// Pairs the requests of one side of the link with the responses of the
+// other. Frames go in oldest first by their micros() timestamp, tagged with
+// their sender (MODULE or MCU); a frame that answers an outstanding request
+// closes it and adds its latency, a known request opens one. Replies that
+// are also sent unsolicited, like REPORT_STATUS_ASYNC, only count while a
+// request waits.
+class TuyaRoundTripTracker {
+public:
+  TuyaRoundTripTracker();
+
+  void observe(uint8_t sender, uint8_t command, uint32_t timestamp);
+  bool isRequest(uint8_t sender, uint8_t command) const;
+  const TuyaRoundTripStats& stats() const;
+  void reset();
+
+private:
+  TuyaRoundTripStats _stats;
+  uint32_t _sentAt[TUYA_STATS_COMMANDS];
+  uint64_t _pending;
+
+  void expire(uint32_t timestamp);
+};
+
+#endif // TUYA_ROUND_TRIP_H
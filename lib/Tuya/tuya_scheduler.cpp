@@ -0,0 +1,106 @@
+#include "tuya_scheduler.h"
+
+TuyaScheduler::TuyaScheduler() : _nextDue(0), _hasNext(false) {
+  for (uint8_t i = 0; i < TUYA_MAX_TIMERS; i++) {
+    _timers[i] = { nullptr, nullptr, 0, 0, false, false };
+  }
+}
+
+int8_t TuyaScheduler::every(uint32_t interval, TuyaTimerCallback callback, void* context) {
+  return add(interval, interval, callback, context, true);
+}
+
+int8_t TuyaScheduler::after(uint32_t delay, TuyaTimerCallback callback, void* context) {
+  return add(delay, delay, callback, context, false);
+}
+
+void TuyaScheduler::setInterval(int8_t id, uint32_t interval) {
+  if (id < 0 || id >= TUYA_MAX_TIMERS || !_timers[id].active) {
+    return;
+  }
+  _timers[id].interval = interval;
+  _timers[id].due = (uint32_t)(millis() + interval);
+  updateNextDue();
+}
+
+void TuyaScheduler::trigger(int8_t id) {
+  if (id < 0 || id >= TUYA_MAX_TIMERS || !_timers[id].active) {
+    return;
+  }
+  _timers[id].due = (uint32_t)millis();
+  updateNextDue();
+}
+
+void TuyaScheduler::cancel(int8_t id) {
+  if (id < 0 || id >= TUYA_MAX_TIMERS) {
+    return;
+  }
+  _timers[id].active = false;
+  updateNextDue();
+}
+
+bool TuyaScheduler::run(uint32_t now) {
+  if (!_hasNext || (int32_t)(now - _nextDue) < 0) {
+    return false;
+  }
+
+  bool ran = false;
+  for (uint8_t i = 0; i < TUYA_MAX_TIMERS; i++) {
+    TuyaTimer& timer = _timers[i];
+    if (!timer.active || (int32_t)(now - timer.due) < 0) {
+      continue;
+    }
+
+    if (timer.repeat) {
+      timer.due += timer.interval;
+      // Skip missed periods instead of firing a burst to catch up
+      if ((int32_t)(now - timer.due) >= 0) {
+        timer.due = now + timer.interval;
+      }
+    } else {
+      timer.active = false;
+    }
+
+    timer.callback(timer.context);
+    ran = true;
+  }
+
+  updateNextDue();
+  return ran;
+}
+
+uint32_t TuyaScheduler::timeUntilNext(uint32_t now) const {
+  if (!_hasNext) {
+    return UINT32_MAX;
+  }
+  int32_t remaining = (int32_t)(_nextDue - now);
+  return remaining > 0 ? remaining : 0;
+}
+
+int8_t TuyaScheduler::add(uint32_t delay, uint32_t interval, TuyaTimerCallback callback, void* context, bool repeat) {
+  if (callback == nullptr) {
+    return TUYA_INVALID_TIMER;
+  }
+
+  for (uint8_t i = 0; i < TUYA_MAX_TIMERS; i++) {
+    if (!_timers[i].active) {
+      _timers[i] = { callback, context, interval, (uint32_t)(millis() + delay), repeat, true };
+      updateNextDue();
+      return i;
+    }
+  }
+  return TUYA_INVALID_TIMER;
+}
+
+void TuyaScheduler::updateNextDue() {
+  _hasNext = false;
+  for (uint8_t i = 0; i < TUYA_MAX_TIMERS; i++) {
+    if (!_timers[i].active) {
+      continue;
+    }
+    if (!_hasNext || (int32_t)(_timers[i].due - _nextDue) < 0) {
+      _nextDue = _timers[i].due;
+      _hasNext = true;
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef TUYA_SCHEDULER_H
+#define TUYA_SCHEDULER_H
+
+#include <Arduino.h>
+
+#define TUYA_MAX_TIMERS 8
+#define TUYA_INVALID_TIMER -1
+
+typedef void (*TuyaTimerCallback)(void* context);
+
+// Structs for scheduler timers
+struct TuyaTimer {
+  TuyaTimerCallback callback;
+  void* context;
+  uint32_t interval;
+  uint32_t due;
+  bool repeat;
+  bool active;
+};
+
+// Cooperative timer scheduler. run() only walks the timer table when the
+// earliest deadline has passed, so an idle pass costs a single comparison.
+class TuyaScheduler {
+public:
+  TuyaScheduler();
+
+  int8_t every(uint32_t interval, TuyaTimerCallback callback, void* context = nullptr);
+  int8_t after(uint32_t delay, TuyaTimerCallback callback, void* context = nullptr);
+  void setInterval(int8_t id, uint32_t interval);
+  void trigger(int8_t id);
+  void cancel(int8_t id);
+
+  bool run(uint32_t now);
+  uint32_t timeUntilNext(uint32_t now) const;
+
+private:
+  TuyaTimer _timers[TUYA_MAX_TIMERS];
+  uint32_t _nextDue;
+  bool _hasNext;
+
+  int8_t add(uint32_t delay, uint32_t interval, TuyaTimerCallback callback, void* context, bool repeat);
+  void updateNextDue();
+};
+
+#endif // TUYA_SCHEDULER_H
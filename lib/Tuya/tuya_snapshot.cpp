@@ -0,0 +1,112 @@
+#include "tuya_snapshot.h"
+
+TuyaSnapshotWriter::TuyaSnapshotWriter(uint8_t* buffer, uint16_t size)
+  : _buffer(buffer), _size(size), _length(0), _overflowed(false) {
+}
+
+void TuyaSnapshotWriter::putU8(uint8_t value) {
+  putBytes(&value, 1);
+}
+
+void TuyaSnapshotWriter::putU16(uint16_t value) {
+  uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+  putBytes(bytes, sizeof(bytes));
+}
+
+void TuyaSnapshotWriter::putI32(int32_t value) {
+  uint32_t raw = value;
+  uint8_t bytes[4] = { (uint8_t)raw, (uint8_t)(raw >> 8), (uint8_t)(raw >> 16), (uint8_t)(raw >> 24) };
+  putBytes(bytes, sizeof(bytes));
+}
+
+// Length-prefixed, without the terminator
+void TuyaSnapshotWriter::putString(const char* value) {
+  size_t length = strlen(value);
+  if (length > UINT8_MAX) {
+    length = UINT8_MAX;
+  }
+  putU8(length);
+  putBytes(reinterpret_cast<const uint8_t*>(value), length);
+}
+
+void TuyaSnapshotWriter::putBytes(const uint8_t* data, uint16_t length) {
+  if (_overflowed || _size - _length < length) {
+    _overflowed = true;
+    return;
+  }
+  memcpy(_buffer + _length, data, length);
+  _length += length;
+}
+
+uint16_t TuyaSnapshotWriter::length() const {
+  return _length;
+}
+
+bool TuyaSnapshotWriter::overflowed() const {
+  return _overflowed;
+}
+
+TuyaSnapshotReader::TuyaSnapshotReader(const uint8_t* data, uint16_t length)
+  : _data(data), _length(length), _position(0), _failed(false) {
+}
+
+uint8_t TuyaSnapshotReader::getU8() {
+  const uint8_t* bytes = getBytes(1);
+  return bytes != nullptr ? bytes[0] : 0;
+}
+
+uint16_t TuyaSnapshotReader::getU16() {
+  const uint8_t* bytes = getBytes(2);
+  return bytes != nullptr ? bytes[0] | (bytes[1] << 8) : 0;
+}
+
+int32_t TuyaSnapshotReader::getI32() {
+  const uint8_t* bytes = getBytes(4);
+  if (bytes == nullptr) {
+    return 0;
+  }
+  return (int32_t)(bytes[0] | (bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24));
+}
+
+// Fails on a string longer than the output rather than truncating it
+bool TuyaSnapshotReader::getString(char* out, size_t size) {
+  uint8_t length = getU8();
+  const uint8_t* bytes = getBytes(length);
+  if (bytes == nullptr || length >= size) {
+    _failed = true;
+    return false;
+  }
+  memcpy(out, bytes, length);
+  out[length] = '\0';
+  return true;
+}
+
+const uint8_t* TuyaSnapshotReader::getBytes(uint16_t length) {
+  if (_failed || _length - _position < length) {
+    _failed = true;
+    return nullptr;
+  }
+  const uint8_t* bytes = _data + _position;
+  _position += length;
+  return bytes;
+}
+
+uint16_t TuyaSnapshotReader::remaining() const {
+  return _length - _position;
+}
+
+bool TuyaSnapshotReader::failed() const {
+  return _failed;
+}
+
+// CRC-16/CCITT-FALSE, bitwise: a snapshot is a few dozen bytes
+uint16_t tuyaCrc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
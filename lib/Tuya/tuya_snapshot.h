@@ -0,0 +1,80 @@
+#ifndef TUYA_SNAPSHOT_H
+#define TUYA_SNAPSHOT_H
+
+#include <Arduino.h>
+
+// Bump when the layout of any section changes, older blobs are then ignored
+#define TUYA_SNAPSHOT_VERSION 1
+#define TUYA_SNAPSHOT_SIZE 128
+// Magic, version and payload length in front, CRC-16 behind
+#define TUYA_SNAPSHOT_HEADER_SIZE 5
+#define TUYA_SNAPSHOT_OVERHEAD (TUYA_SNAPSHOT_HEADER_SIZE + 2)
+
+// Shortest time between two writes of a changed snapshot
+#ifndef TUYA_SNAPSHOT_INTERVAL
+#define TUYA_SNAPSHOT_INTERVAL 60000
+#endif
+
+// Readings change with every report; on their own they are written at most
+// this often to spare the flash
+#ifndef TUYA_SNAPSHOT_READINGS_INTERVAL
+#define TUYA_SNAPSHOT_READINGS_INTERVAL 21600000UL
+#endif
+
+// Backing storage of a device snapshot: NVS on ESP32, a file on a host.
+// load() returns the stored length, 0 when there is nothing usable.
+class TuyaStateStore {
+public:
+  virtual ~TuyaStateStore() {}
+
+  virtual size_t load(uint8_t* data, size_t size) = 0;
+  virtual bool save(const uint8_t* data, size_t length) = 0;
+};
+
+// Little-endian field writer over a fixed buffer. A field that does not fit
+// marks the writer as overflowed and is not written.
+class TuyaSnapshotWriter {
+public:
+  TuyaSnapshotWriter(uint8_t* buffer, uint16_t size);
+
+  void putU8(uint8_t value);
+  void putU16(uint16_t value);
+  void putI32(int32_t value);
+  void putString(const char* value);
+  void putBytes(const uint8_t* data, uint16_t length);
+
+  uint16_t length() const;
+  bool overflowed() const;
+
+private:
+  uint8_t* _buffer;
+  uint16_t _size;
+  uint16_t _length;
+  bool _overflowed;
+};
+
+// Reader matching TuyaSnapshotWriter. Reading past the end marks the reader
+// as failed and returns zeros.
+class TuyaSnapshotReader {
+public:
+  TuyaSnapshotReader(const uint8_t* data, uint16_t length);
+
+  uint8_t getU8();
+  uint16_t getU16();
+  int32_t getI32();
+  bool getString(char* out, size_t size);
+  const uint8_t* getBytes(uint16_t length);
+
+  uint16_t remaining() const;
+  bool failed() const;
+
+private:
+  const uint8_t* _data;
+  uint16_t _length;
+  uint16_t _position;
+  bool _failed;
+};
+
+uint16_t tuyaCrc16(const uint8_t* data, size_t length);
+
+#endif // TUYA_SNAPSHOT_H
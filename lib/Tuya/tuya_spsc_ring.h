@@ -0,0 +1,84 @@
+#ifndef TUYA_SPSC_RING_H
+#define TUYA_SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer byte ring. One thread or task may
+// call write(), one other may call read(); neither ever blocks. Capacity must
+// be a power of two.
+template <size_t Capacity>
+class TuyaSpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+  TuyaSpscRing() : _head(0), _tail(0), _dropped(0) {}
+
+  // Producer side: copies as many bytes as fit and returns how many did.
+  // Bytes that do not fit are counted in dropped().
+  size_t write(const uint8_t* data, size_t length) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t tail = _tail.load(std::memory_order_acquire);
+    size_t space = Capacity - (head - tail);
+    size_t count = length < space ? length : space;
+
+    size_t index = head & (Capacity - 1);
+    size_t first = count < Capacity - index ? count : Capacity - index;
+    memcpy(_buffer + index, data, first);
+    memcpy(_buffer, data + first, count - first);
+
+    _head.store(head + count, std::memory_order_release);
+    if (count < length) {
+      _dropped.fetch_add(length - count, std::memory_order_relaxed);
+    }
+    return count;
+  }
+
+  // Consumer side: copies up to length bytes out and returns how many did
+  size_t read(uint8_t* data, size_t length) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t available = head - tail;
+    size_t count = length < available ? length : available;
+
+    size_t index = tail & (Capacity - 1);
+    size_t first = count < Capacity - index ? count : Capacity - index;
+    memcpy(data, _buffer + index, first);
+    memcpy(data + first, _buffer, count - first);
+
+    _tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  int read() {
+    uint8_t byte;
+    return read(&byte, 1) == 1 ? byte : -1;
+  }
+
+  int peek() const {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (_head.load(std::memory_order_acquire) == tail) {
+      return -1;
+    }
+    return _buffer[tail & (Capacity - 1)];
+  }
+
+  size_t available() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+  }
+
+  size_t dropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  uint8_t _buffer[Capacity];
+  // Producer and consumer indices on separate cache lines
+  alignas(64) std::atomic<size_t> _head;
+  alignas(64) std::atomic<size_t> _tail;
+  std::atomic<size_t> _dropped;
+};
+
+#endif // TUYA_SPSC_RING_H
@@ -0,0 +1,69 @@
+#ifndef TUYA_STATIC_FRAME_H
+#define TUYA_STATIC_FRAME_H
+
+#include <Arduino.h>
+#include "tuya.h"
+
+// Frame whose header, payload layout and checksum are computed at compile
+// time. Payload bytes that are only known at runtime are patched with set(),
+// which adjusts the checksum by the difference instead of summing the frame
+// again.
+template <TuyaDeviceType Version, TuyaCommandType Command, uint16_t Length = 0>
+struct TuyaStaticFrame {
+  static constexpr uint16_t size = TUYA_HEADER_SIZE + Length + 1;
+
+  uint8_t bytes[size];
+
+  constexpr TuyaStaticFrame() : bytes() {
+    bytes[0] = 0x55;
+    bytes[1] = 0xAA;
+    bytes[2] = Version;
+    bytes[3] = Command;
+    bytes[4] = (Length >> 8) & 0xFF;
+    bytes[5] = Length & 0xFF;
+
+    uint8_t sum = 0;
+    for (uint16_t i = 0; i < size - 1; i++) {
+      sum += bytes[i];
+    }
+    bytes[size - 1] = sum;
+  }
+
+  constexpr void set(uint16_t index, uint8_t value) {
+    uint8_t& target = bytes[TUYA_HEADER_SIZE + index];
+    bytes[size - 1] += value - target;
+    target = value;
+  }
+
+  constexpr uint8_t checksum() const {
+    return bytes[size - 1];
+  }
+};
+
+// SEND_COMMAND frame carrying a single DT_VALUE data point. Everything except
+// the four value bytes is constant for a given DP.
+template <uint8_t DpId>
+struct TuyaDpValueFrame : TuyaStaticFrame<MODULE, SEND_COMMAND, 8> {
+  constexpr TuyaDpValueFrame() : TuyaStaticFrame() {
+    set(0, DpId);
+    set(1, DT_VALUE);
+    set(2, 0x00);
+    set(3, 0x04);
+  }
+
+  void setValue(int32_t value) {
+    set(4, (value >> 24) & 0xFF);
+    set(5, (value >> 16) & 0xFF);
+    set(6, (value >> 8) & 0xFF);
+    set(7, value & 0xFF);
+  }
+
+  static TuyaDpValueFrame make(int32_t value) {
+    constexpr TuyaDpValueFrame prototype;
+    TuyaDpValueFrame frame = prototype;
+    frame.setValue(value);
+    return frame;
+  }
+};
+
+#endif // TUYA_STATIC_FRAME_H
@@ -0,0 +1,40 @@
+#include "tuya_stats.h"
+
+void TuyaHistogram::add(uint32_t value) {
+  uint8_t bucket = 0;
+  while (value != 0 && bucket < TUYA_HISTOGRAM_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  buckets[bucket]++;
+}
+
+uint32_t TuyaHistogram::count() const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < TUYA_HISTOGRAM_BUCKETS; i++) {
+    total += buckets[i];
+  }
+  return total;
+}
+
+// Upper bound of the bucket holding the given percentile, 0 when empty. The
+// last bucket is open-ended and reports UINT32_MAX.
+uint32_t TuyaHistogram::percentile(uint8_t percent) const {
+  uint32_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (uint8_t i = 0; i < TUYA_HISTOGRAM_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= rank && seen > 0) {
+      if (i == TUYA_HISTOGRAM_BUCKETS - 1) {
+        return UINT32_MAX;
+      }
+      return i == 0 ? 0 : (1UL << i) - 1;
+    }
+  }
+  return UINT32_MAX;
+}
@@ -0,0 +1,47 @@
+#ifndef TUYA_STATS_H
+#define TUYA_STATS_H
+
+#include <Arduino.h>
+
+// Command bytes at or above this share the last counter slot
+#define TUYA_STATS_COMMANDS 64
+// Enough for round trips in µs up to about 4 s
+#ifndef TUYA_HISTOGRAM_BUCKETS
+#define TUYA_HISTOGRAM_BUCKETS 24
+#endif
+
+// Power-of-two histogram: bucket 0 counts zeros, bucket i counts values in
+// [2^(i-1), 2^i) and the last bucket everything larger. add() is a few
+// instructions, so it can stay on in production builds.
+struct TuyaHistogram {
+  uint32_t buckets[TUYA_HISTOGRAM_BUCKETS];
+
+  void add(uint32_t value);
+  uint32_t count() const;
+  uint32_t percentile(uint8_t percent) const;
+};
+
+// Link health counters, updated with plain increments from loop(). The
+// struct has no pointers, so a copy is a complete snapshot.
+struct TuyaStats {
+  uint32_t rxFrames[TUYA_STATS_COMMANDS];
+  uint32_t txFrames[TUYA_STATS_COMMANDS];
+  uint32_t bytesIn;
+  uint32_t bytesOut;
+  uint32_t checksumErrors;
+  uint32_t overflowErrors;
+  uint32_t skippedBytes;
+  uint32_t txDropped;
+  uint32_t loops;
+  uint32_t timeToInitialized;
+  uint32_t timeToReady;
+  TuyaHistogram interArrival;
+  TuyaHistogram parseLatency;
+  TuyaHistogram loopDuration;
+};
+
+inline uint8_t tuyaStatsSlot(uint8_t command) {
+  return command < TUYA_STATS_COMMANDS ? command : TUYA_STATS_COMMANDS - 1;
+}
+
+#endif // TUYA_STATS_H
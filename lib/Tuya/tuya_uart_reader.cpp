@@ -0,0 +1,68 @@
+#include "tuya_uart_reader.h"
+
+#if defined(ESP32)
+
+TuyaUartReader::TuyaUartReader() : _pSerial(nullptr), _task(nullptr) {
+}
+
+bool TuyaUartReader::begin(HardwareSerial& serial, BaseType_t core, UBaseType_t priority) {
+  _pSerial = &serial;
+  if (xTaskCreatePinnedToCore(readerTask, "tuya_uart", 2048, this, priority, &_task, core) != pdPASS) {
+    _task = nullptr;
+    return false;
+  }
+
+  // Runs in the UART driver's event task, only wake the reader from there
+  _pSerial->onReceive([this]() {
+    xTaskNotifyGive(_task);
+  });
+  return true;
+}
+
+size_t TuyaUartReader::dropped() const {
+  return _ring.dropped();
+}
+
+int TuyaUartReader::available() {
+  return _ring.available();
+}
+
+int TuyaUartReader::read() {
+  return _ring.read();
+}
+
+int TuyaUartReader::peek() {
+  return _ring.peek();
+}
+
+size_t TuyaUartReader::write(uint8_t value) {
+  return _pSerial != nullptr ? _pSerial->write(value) : 0;
+}
+
+size_t TuyaUartReader::write(const uint8_t* buffer, size_t size) {
+  return _pSerial != nullptr ? _pSerial->write(buffer, size) : 0;
+}
+
+void TuyaUartReader::flush() {
+  if (_pSerial != nullptr) {
+    _pSerial->flush();
+  }
+}
+
+void TuyaUartReader::readerTask(void* context) {
+  TuyaUartReader* reader = static_cast<TuyaUartReader*>(context);
+  uint8_t buffer[128];
+
+  for (;;) {
+    // The timeout only matters if an event is ever missed
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+
+    int available;
+    while ((available = reader->_pSerial->available()) > 0) {
+      size_t count = reader->_pSerial->read(buffer, available < (int)sizeof(buffer) ? available : sizeof(buffer));
+      reader->_ring.write(buffer, count);
+    }
+  }
+}
+
+#endif // ESP32
@@ -0,0 +1,45 @@
+#ifndef TUYA_UART_READER_H
+#define TUYA_UART_READER_H
+
+#if defined(ESP32)
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "tuya_spsc_ring.h"
+
+#ifndef TUYA_UART_RING_SIZE
+#define TUYA_UART_RING_SIZE 2048
+#endif
+
+// Stream backed by a ring that a small reader task, pinned to its own core,
+// fills from the UART as receive events arrive. Pass it to Tuya::begin() in
+// place of the HardwareSerial: slow callbacks on the loop task then no longer
+// overflow the UART RX FIFO. Writes go straight to the UART.
+class TuyaUartReader : public Stream {
+public:
+  TuyaUartReader();
+
+  bool begin(HardwareSerial& serial, BaseType_t core = 0, UBaseType_t priority = 5);
+  size_t dropped() const;
+
+  int available() override;
+  int read() override;
+  int peek() override;
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void flush() override;
+
+private:
+  HardwareSerial* _pSerial;
+  TaskHandle_t _task;
+  TuyaSpscRing<TUYA_UART_RING_SIZE> _ring;
+
+  static void readerTask(void* context);
+};
+
+#endif // ESP32
+
+#endif // TUYA_UART_READER_H
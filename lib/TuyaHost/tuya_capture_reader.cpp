@@ -0,0 +1,61 @@
+#include "tuya_capture_reader.h"
+
+#include <string.h>
+
+TuyaCaptureReader::TuyaCaptureReader() : _offset(0) {
+}
+
+bool TuyaCaptureReader::open(const char* path) {
+  close();
+  if (!_file.open(path)) {
+    return false;
+  }
+
+  const uint8_t* data = _file.data();
+  if (_file.size() < TUYA_CAPTURE_HEADER_SIZE ||
+      memcmp(data, TUYA_CAPTURE_MAGIC, TUYA_CAPTURE_HEADER_SIZE - 1) != 0 ||
+      data[TUYA_CAPTURE_HEADER_SIZE - 1] != TUYA_CAPTURE_VERSION) {
+    close();
+    return false;
+  }
+
+  _offset = TUYA_CAPTURE_HEADER_SIZE;
+  return true;
+}
+
+void TuyaCaptureReader::close() {
+  _file.close();
+  _offset = 0;
+}
+
+bool TuyaCaptureReader::next(TuyaCaptureRecord& record) {
+  size_t size = _file.size();
+  if (_offset + TUYA_CAPTURE_RECORD_HEADER_SIZE > size) {
+    return false;
+  }
+
+  const uint8_t* header = _file.data() + _offset;
+  uint16_t length = header[9] | (header[10] << 8);
+  if (_offset + TUYA_CAPTURE_RECORD_HEADER_SIZE + length > size) {
+    // Truncated last record, e.g. a capture cut off by a reset
+    return false;
+  }
+
+  record.timestamp = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    record.timestamp |= (uint64_t)header[i] << (8 * i);
+  }
+  record.direction = static_cast<TuyaCaptureDirection>(header[8]);
+  record.length = length;
+  record.data = header + TUYA_CAPTURE_RECORD_HEADER_SIZE;
+  _offset += TUYA_CAPTURE_RECORD_HEADER_SIZE + length;
+  return true;
+}
+
+void TuyaCaptureReader::rewind() {
+  _offset = _file.data() != nullptr ? TUYA_CAPTURE_HEADER_SIZE : 0;
+}
+
+size_t TuyaCaptureReader::size() const {
+  return _file.size();
+}
@@ -0,0 +1,36 @@
+#ifndef TUYA_CAPTURE_READER_H
+#define TUYA_CAPTURE_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tuya_capture.h>
+#include "tuya_mapped_file.h"
+
+// Structs for capture records
+struct TuyaCaptureRecord {
+  uint64_t timestamp;
+  TuyaCaptureDirection direction;
+  uint16_t length;
+  const uint8_t* data;
+};
+
+// Memory-maps a capture file and hands out records that point straight into
+// the mapping, so reading a record never copies frame bytes.
+class TuyaCaptureReader {
+public:
+  TuyaCaptureReader();
+
+  bool open(const char* path);
+  void close();
+
+  bool next(TuyaCaptureRecord& record);
+  void rewind();
+
+  size_t size() const;
+
+private:
+  TuyaMappedFile _file;
+  size_t _offset;
+};
+
+#endif // TUYA_CAPTURE_READER_H
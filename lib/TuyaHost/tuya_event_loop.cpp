@@ -0,0 +1,147 @@
+#include "tuya_event_loop.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+TuyaEventLoop::TuyaEventLoop() : _epoll(epoll_create1(EPOLL_CLOEXEC)), _count(0), _running(false) {
+}
+
+TuyaEventLoop::~TuyaEventLoop() {
+  if (_epoll >= 0) {
+    ::close(_epoll);
+  }
+}
+
+bool TuyaEventLoop::add(TuyaFdStream& stream, Tuya& device) {
+  if (_epoll < 0 || stream.fd() < 0 || _count >= TUYA_EVENT_LOOP_DEVICES) {
+    return false;
+  }
+
+  Entry& entry = _entries[_count];
+  entry = { &stream, &device, true };
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u32 = _count;
+  if (epoll_ctl(_epoll, EPOLL_CTL_ADD, stream.fd(), &event) != 0) {
+    return false;
+  }
+  _count++;
+  return true;
+}
+
+bool TuyaEventLoop::remove(TuyaFdStream& stream) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_entries[i].stream != &stream) {
+      continue;
+    }
+
+    unwatch(_entries[i]);
+    // Keep epoll's slot numbers valid by moving the last entry into the gap
+    _count--;
+    if (i != _count) {
+      _entries[i] = _entries[_count];
+      if (_entries[i].watching) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        epoll_ctl(_epoll, EPOLL_CTL_MOD, _entries[i].stream->fd(), &event);
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+uint8_t TuyaEventLoop::size() const {
+  return _count;
+}
+
+// Waits for input or the next due timer, then runs loop() on every device
+// that has work. Returns the number of devices that ran, or -1 on error.
+int TuyaEventLoop::runOnce(int maxWait) {
+  bool ready[TUYA_EVENT_LOOP_DEVICES] = {};
+  if (poll(maxWait, ready) < 0) {
+    return -1;
+  }
+
+  int count = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (ready[i] || _entries[i].device->timeUntilNext() == 0) {
+      _entries[i].device->loop();
+      count++;
+    }
+  }
+  return count;
+}
+
+// Same wait, but leaves running the devices to the caller: ready gets the
+// bit getId() of every device whose stream received input, as TuyaBus::loop()
+// takes it. Returns the number of readable devices, or -1 on error.
+int TuyaEventLoop::wait(int maxWait, uint32_t& ready) {
+  bool readable[TUYA_EVENT_LOOP_DEVICES] = {};
+  int count = poll(maxWait, readable);
+  ready = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    uint8_t id = _entries[i].device->getId();
+    if (readable[i] && id < 32) {
+      ready |= 1UL << id;
+    }
+  }
+  return count;
+}
+
+// Sleeps in epoll_wait() until input or the earliest timer, then moves the
+// input of every readable descriptor into its stream
+int TuyaEventLoop::poll(int maxWait, bool (&ready)[TUYA_EVENT_LOOP_DEVICES]) {
+  uint32_t wait = maxWait < 0 ? UINT32_MAX : maxWait;
+  for (uint8_t i = 0; i < _count; i++) {
+    uint32_t next = _entries[i].device->timeUntilNext();
+    if (next < wait) {
+      wait = next;
+    }
+  }
+
+  struct epoll_event events[TUYA_EVENT_LOOP_DEVICES];
+  int timeout = wait > INT32_MAX ? -1 : (int)wait;
+  int count = epoll_wait(_epoll, events, TUYA_EVENT_LOOP_DEVICES, timeout);
+  if (count < 0) {
+    return errno == EINTR ? 0 : -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    uint32_t slot = events[i].data.u32;
+    if (slot >= _count) {
+      continue;
+    }
+
+    Entry& entry = _entries[slot];
+    if (events[i].events & EPOLLIN) {
+      entry.stream->fill();
+    }
+    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+      // A closed tty or pty stays readable forever, stop watching it
+      unwatch(entry);
+    }
+    ready[slot] = true;
+  }
+  return count;
+}
+
+void TuyaEventLoop::run() {
+  _running = true;
+  while (_running && runOnce() >= 0) {
+  }
+}
+
+void TuyaEventLoop::stop() {
+  _running = false;
+}
+
+void TuyaEventLoop::unwatch(Entry& entry) {
+  if (entry.watching) {
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, entry.stream->fd(), nullptr);
+    entry.watching = false;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef TUYA_EVENT_LOOP_H
+#define TUYA_EVENT_LOOP_H
+
+#include <tuya.h>
+#include "tuya_fd_stream.h"
+
+#define TUYA_EVENT_LOOP_DEVICES 16
+
+// epoll loop driving several Tuya devices from one thread. A device's loop()
+// only runs when its descriptor has bytes or one of its timers is due; in
+// between the thread sleeps in epoll_wait() for as long as the earliest
+// timer allows.
+class TuyaEventLoop {
+public:
+  TuyaEventLoop();
+  ~TuyaEventLoop();
+
+  bool add(TuyaFdStream& stream, Tuya& device);
+  bool remove(TuyaFdStream& stream);
+  uint8_t size() const;
+
+  int runOnce(int maxWait = -1);
+  int wait(int maxWait, uint32_t& ready);
+  void run();
+  void stop();
+
+private:
+  struct Entry {
+    TuyaFdStream* stream;
+    Tuya* device;
+    bool watching;
+  };
+
+  int _epoll;
+  Entry _entries[TUYA_EVENT_LOOP_DEVICES];
+  uint8_t _count;
+  volatile bool _running;
+
+  int poll(int maxWait, bool (&ready)[TUYA_EVENT_LOOP_DEVICES]);
+  void unwatch(Entry& entry);
+
+  TuyaEventLoop(const TuyaEventLoop&);
+  TuyaEventLoop& operator=(const TuyaEventLoop&);
+};
+
+#endif // TUYA_EVENT_LOOP_H
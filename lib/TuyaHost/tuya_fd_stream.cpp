@@ -0,0 +1,168 @@
+#include "tuya_fd_stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Baud rates termios can set, the Tuya MCUs use 9600 or 115200
+static speed_t baudConstant(uint32_t baud) {
+  switch (baud) {
+  case 9600:
+    return B9600;
+  case 19200:
+    return B19200;
+  case 38400:
+    return B38400;
+  case 57600:
+    return B57600;
+  case 115200:
+    return B115200;
+  default:
+    return B0;
+  }
+}
+
+TuyaFdStream::TuyaFdStream() : _fd(-1), _owned(false), _read(0), _end(0) {
+}
+
+TuyaFdStream::~TuyaFdStream() {
+  close();
+}
+
+bool TuyaFdStream::open(const char* path, uint32_t baud) {
+  close();
+
+  speed_t speed = baudConstant(baud);
+  if (speed == B0) {
+    return false;
+  }
+
+  int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct termios settings;
+  if (tcgetattr(fd, &settings) != 0) {
+    ::close(fd);
+    return false;
+  }
+  cfmakeraw(&settings);
+  settings.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+  settings.c_cflag |= CS8 | CLOCAL | CREAD;
+  settings.c_cc[VMIN] = 0;
+  settings.c_cc[VTIME] = 0;
+  cfsetispeed(&settings, speed);
+  cfsetospeed(&settings, speed);
+  if (tcsetattr(fd, TCSANOW, &settings) != 0) {
+    ::close(fd);
+    return false;
+  }
+  tcflush(fd, TCIOFLUSH);
+
+  _fd = fd;
+  _owned = true;
+  return true;
+}
+
+// Uses an already open descriptor, e.g. a pty, which stays owned by the caller
+bool TuyaFdStream::attach(int fd) {
+  close();
+
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+    return false;
+  }
+
+  _fd = fd;
+  _owned = false;
+  return true;
+}
+
+void TuyaFdStream::close() {
+  if (_fd >= 0 && _owned) {
+    ::close(_fd);
+  }
+  _fd = -1;
+  _owned = false;
+  _read = 0;
+  _end = 0;
+}
+
+int TuyaFdStream::fd() const {
+  return _fd;
+}
+
+// Reads whatever the descriptor has, up to the free space, in one syscall.
+// Returns false once the other end is gone.
+bool TuyaFdStream::fill() {
+  if (_fd < 0) {
+    return false;
+  }
+  if (_read == _end) {
+    _read = 0;
+    _end = 0;
+  }
+  if (_end == sizeof(_buffer)) {
+    return true;
+  }
+
+  ssize_t count = ::read(_fd, _buffer + _end, sizeof(_buffer) - _end);
+  if (count > 0) {
+    _end += count;
+    return true;
+  }
+  return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+int TuyaFdStream::available() {
+  if (_read == _end) {
+    fill();
+  }
+  return _end - _read;
+}
+
+int TuyaFdStream::read() {
+  if (available() == 0) {
+    return -1;
+  }
+  return _buffer[_read++];
+}
+
+int TuyaFdStream::peek() {
+  if (available() == 0) {
+    return -1;
+  }
+  return _buffer[_read];
+}
+
+size_t TuyaFdStream::write(uint8_t value) {
+  return write(&value, 1);
+}
+
+// Blocks in poll() while the kernel buffer is full, frames are never split
+size_t TuyaFdStream::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (_fd >= 0 && written < size) {
+    ssize_t count = ::write(_fd, buffer + written, size - written);
+    if (count > 0) {
+      written += count;
+    } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      struct pollfd target = { _fd, POLLOUT, 0 };
+      poll(&target, 1, 100);
+    } else if (count < 0 && errno == EINTR) {
+      continue;
+    } else {
+      break;
+    }
+  }
+  return written;
+}
+
+void TuyaFdStream::flush() {
+  if (_fd >= 0) {
+    tcdrain(_fd);
+  }
+}
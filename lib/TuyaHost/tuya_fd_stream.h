@@ -0,0 +1,44 @@
+#ifndef TUYA_FD_STREAM_H
+#define TUYA_FD_STREAM_H
+
+#include <Arduino.h>
+#include <Stream.h>
+
+#define TUYA_FD_BUFFER_SIZE 4096
+
+// Stream over a nonblocking file descriptor, typically a tty set to raw 8N1
+// with termios or one side of a pty. Bytes are pulled in batches: one read()
+// refills the whole buffer when it runs empty, so the per-byte Stream calls
+// made by Tuya::loop() do not cost a syscall each.
+class TuyaFdStream : public Stream {
+public:
+  TuyaFdStream();
+  ~TuyaFdStream();
+
+  bool open(const char* path, uint32_t baud);
+  bool attach(int fd);
+  void close();
+
+  int fd() const;
+  bool fill();
+
+  int available() override;
+  int read() override;
+  int peek() override;
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void flush() override;
+
+private:
+  int _fd;
+  bool _owned;
+  uint8_t _buffer[TUYA_FD_BUFFER_SIZE];
+  size_t _read;
+  size_t _end;
+
+  TuyaFdStream(const TuyaFdStream&);
+  TuyaFdStream& operator=(const TuyaFdStream&);
+};
+
+#endif // TUYA_FD_STREAM_H
@@ -0,0 +1,36 @@
+#include "tuya_file_store.h"
+
+#include <stdio.h>
+
+TuyaFileStore::TuyaFileStore(const std::string& path) : _path(path) {
+}
+
+size_t TuyaFileStore::load(uint8_t* data, size_t size) {
+  FILE* file = fopen(_path.c_str(), "rb");
+  if (file == nullptr) {
+    return 0;
+  }
+  size_t length = fread(data, 1, size, file);
+  // A file larger than the buffer is not a snapshot this build wrote
+  if (length == size && fgetc(file) != EOF) {
+    length = 0;
+  }
+  fclose(file);
+  return length;
+}
+
+bool TuyaFileStore::save(const uint8_t* data, size_t length) {
+  std::string temporary = _path + ".tmp";
+  FILE* file = fopen(temporary.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written = fwrite(data, 1, length, file) == length;
+  written = fflush(file) == 0 && written;
+  written = fclose(file) == 0 && written;
+  if (!written || rename(temporary.c_str(), _path.c_str()) != 0) {
+    remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
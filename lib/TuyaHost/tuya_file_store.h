@@ -0,0 +1,20 @@
+#ifndef TUYA_FILE_STORE_H
+#define TUYA_FILE_STORE_H
+
+#include <string>
+#include <tuya_snapshot.h>
+
+// Snapshot kept in a file. save() writes a temporary file next to it and
+// renames it over the old one, so a crash leaves either snapshot intact.
+class TuyaFileStore : public TuyaStateStore {
+public:
+  TuyaFileStore(const std::string& path);
+
+  size_t load(uint8_t* data, size_t size) override;
+  bool save(const uint8_t* data, size_t length) override;
+
+private:
+  std::string _path;
+};
+
+#endif // TUYA_FILE_STORE_H
@@ -0,0 +1,55 @@
+#include "tuya_mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TuyaMappedFile::TuyaMappedFile() : _data(nullptr), _size(0) {
+}
+
+TuyaMappedFile::~TuyaMappedFile() {
+  close();
+}
+
+bool TuyaMappedFile::open(const char* path) {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+  _data = static_cast<const uint8_t*>(mapping);
+  _size = info.st_size;
+  return true;
+}
+
+void TuyaMappedFile::close() {
+  if (_data != nullptr) {
+    munmap(const_cast<uint8_t*>(_data), _size);
+  }
+  _data = nullptr;
+  _size = 0;
+}
+
+const uint8_t* TuyaMappedFile::data() const {
+  return _data;
+}
+
+size_t TuyaMappedFile::size() const {
+  return _size;
+}
@@ -0,0 +1,27 @@
+#ifndef TUYA_MAPPED_FILE_H
+#define TUYA_MAPPED_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-only memory mapping of a whole file
+class TuyaMappedFile {
+public:
+  TuyaMappedFile();
+  ~TuyaMappedFile();
+
+  bool open(const char* path);
+  void close();
+
+  const uint8_t* data() const;
+  size_t size() const;
+
+private:
+  const uint8_t* _data;
+  size_t _size;
+
+  TuyaMappedFile(const TuyaMappedFile&);
+  TuyaMappedFile& operator=(const TuyaMappedFile&);
+};
+
+#endif // TUYA_MAPPED_FILE_H
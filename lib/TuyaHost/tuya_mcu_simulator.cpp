@@ -0,0 +1,207 @@
+#include "tuya_mcu_simulator.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const uint8_t statusDataPoints[] = {
+  DP_TEMPERATURE, DP_HIGH_TEMPERATURE_THRESHOLD, DP_LOW_TEMPERATURE_THRESHOLD,
+  DP_PH, DP_HIGH_PH_THRESHOLD, DP_LOW_PH_THRESHOLD,
+  DP_TDS, DP_HIGH_TDS_THRESHOLD, DP_LOW_TDS_THRESHOLD,
+};
+
+static const uint8_t measuredDataPoints[] = { DP_TEMPERATURE, DP_PH, DP_TDS };
+
+static const char productInfo[] = "{\"product_id\":\"simulated\",\"version\":\"1.0.0\",\"operation_mode\":0}";
+
+TuyaMcuSimulator::TuyaMcuSimulator()
+  : _master(-1), _slave(-1), _slaveName(), _running(false), _framesReceived(0), _reportsSent(0),
+    _reportInterval(1000), _heartbeatSent(false) {
+  _sensor = {
+    { 255, 320, 180, 1 },
+    { 720, 850, 600, 2 },
+    { 420, 1000, 100, 0 },
+  };
+}
+
+TuyaMcuSimulator::~TuyaMcuSimulator() {
+  stop();
+  if (_master >= 0) {
+    ::close(_master);
+  }
+  if (_slave >= 0) {
+    ::close(_slave);
+  }
+}
+
+bool TuyaMcuSimulator::open() {
+  if (openpty(&_master, &_slave, _slaveName, nullptr, nullptr) != 0) {
+    return false;
+  }
+
+  // Raw on both sides, the line discipline must not touch 0x0A or 0x0D
+  struct termios settings;
+  tcgetattr(_slave, &settings);
+  cfmakeraw(&settings);
+  tcsetattr(_slave, TCSANOW, &settings);
+  return true;
+}
+
+int TuyaMcuSimulator::slaveFd() const {
+  return _slave;
+}
+
+const char* TuyaMcuSimulator::slaveName() const {
+  return _slaveName;
+}
+
+bool TuyaMcuSimulator::start(uint32_t reportInterval) {
+  if (_master < 0 || _running) {
+    return false;
+  }
+
+  _reportInterval = reportInterval;
+  _running = true;
+  _thread = std::thread(&TuyaMcuSimulator::run, this);
+  return true;
+}
+
+void TuyaMcuSimulator::stop() {
+  _running = false;
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+uint32_t TuyaMcuSimulator::framesReceived() const {
+  return _framesReceived;
+}
+
+uint32_t TuyaMcuSimulator::reportsSent() const {
+  return _reportsSent;
+}
+
+void TuyaMcuSimulator::run() {
+  uint8_t buffer[256];
+  uint32_t nextReport = millis() + _reportInterval;
+
+  while (_running) {
+    int32_t wait = (int32_t)(nextReport - millis());
+    struct pollfd target = { _master, POLLIN, 0 };
+    int ready = poll(&target, 1, wait > 0 ? wait : 0);
+
+    if (ready > 0 && (target.revents & POLLIN)) {
+      ssize_t count = ::read(_master, buffer, sizeof(buffer));
+      for (ssize_t i = 0; i < count; i++) {
+        TuyaErrorTransmission result = _parser.push(buffer[i]);
+        while (result != ERROR_NO_DATA) {
+          if (result == ERROR_NONE) {
+            _framesReceived++;
+            handleFrame(_parser.view());
+          }
+          result = _parser.poll();
+        }
+      }
+    }
+
+    if ((int32_t)(millis() - nextReport) >= 0) {
+      drift();
+      sendStatus(measuredDataPoints, sizeof(measuredDataPoints));
+      _reportsSent++;
+      nextReport += _reportInterval;
+    }
+  }
+}
+
+void TuyaMcuSimulator::handleFrame(const TuyaFrameView& frame) {
+  switch (frame.command) {
+  case HEARTBEATS: {
+    // 0x00 only on the first heartbeat after power-up
+    uint8_t state = _heartbeatSent ? 0x01 : 0x00;
+    _heartbeatSent = true;
+    sendFrame(HEARTBEATS, &state, 1);
+    break;
+  }
+  case QUERY_PRODUCT_INFO:
+    sendFrame(QUERY_PRODUCT_INFO, reinterpret_cast<const uint8_t*>(productInfo), sizeof(productInfo) - 1);
+    break;
+  case QUERY_WORKING_MODE:
+  case REPORT_NETWORK_STATUS:
+    sendFrame(frame.command, nullptr, 0);
+    break;
+  case QUERY_DP_STATUS:
+    sendStatus(statusDataPoints, sizeof(statusDataPoints));
+    break;
+  case SEND_COMMAND: {
+    TuyaDataPoint dataPoint;
+    TuyaDataPointReader reader(frame);
+    uint8_t changed[sizeof(statusDataPoints)];
+    uint8_t count = 0;
+    while (reader.next(dataPoint) && count < sizeof(changed)) {
+      if (waterQualityDataPoints.decode(_sensor, dataPoint) != 0) {
+        changed[count++] = dataPoint.id;
+      }
+    }
+    sendStatus(changed, count);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void TuyaMcuSimulator::sendFrame(uint8_t command, const uint8_t* data, uint16_t length) {
+  uint8_t frame[TUYA_MAX_FRAME_SIZE];
+  frame[0] = 0x55;
+  frame[1] = 0xAA;
+  frame[2] = MCU;
+  frame[3] = command;
+  frame[4] = (length >> 8) & 0xFF;
+  frame[5] = length & 0xFF;
+  if (length > 0) {
+    memcpy(frame + TUYA_HEADER_SIZE, data, length);
+  }
+  frame[TUYA_HEADER_SIZE + length] = tuyaChecksum(frame, TUYA_HEADER_SIZE + length);
+
+  size_t size = TUYA_HEADER_SIZE + length + 1;
+  size_t written = 0;
+  while (written < size) {
+    ssize_t count = ::write(_master, frame + written, size - written);
+    if (count <= 0) {
+      return;
+    }
+    written += count;
+  }
+}
+
+void TuyaMcuSimulator::sendStatus(const uint8_t* dataPoints, uint8_t count) {
+  uint8_t data[sizeof(statusDataPoints) * 8];
+  uint16_t length = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>* descriptor = waterQualityDataPoints.find(dataPoints[i]);
+    if (descriptor == nullptr) {
+      continue;
+    }
+
+    int32_t value = waterQualityDataPoints.value(_sensor, *descriptor);
+    uint8_t tlv[8] = {
+      dataPoints[i], DT_VALUE, 0x00, 0x04,
+      (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value,
+    };
+    memcpy(data + length, tlv, sizeof(tlv));
+    length += sizeof(tlv);
+  }
+
+  if (length > 0) {
+    sendFrame(REPORT_STATUS_ASYNC, data, length);
+  }
+}
+
+void TuyaMcuSimulator::drift() {
+  _sensor.temperature.value += rand() % 3 - 1;
+  _sensor.ph.value += rand() % 5 - 2;
+  _sensor.tds.value += rand() % 11 - 5;
+}
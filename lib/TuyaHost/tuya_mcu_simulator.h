@@ -0,0 +1,50 @@
+#ifndef TUYA_MCU_SIMULATOR_H
+#define TUYA_MCU_SIMULATOR_H
+
+#include <atomic>
+#include <thread>
+#include <tuya_water_quality.h>
+
+// Water quality MCU on the master side of a pty, for running the gateway and
+// the fd/epoll backend without hardware. It answers the handshake, applies
+// threshold writes and reports a slowly drifting temperature, pH and TDS.
+// The slave side is a tty the device under test opens like a USB adapter.
+class TuyaMcuSimulator {
+public:
+  TuyaMcuSimulator();
+  ~TuyaMcuSimulator();
+
+  bool open();
+  int slaveFd() const;
+  const char* slaveName() const;
+
+  bool start(uint32_t reportInterval);
+  void stop();
+
+  uint32_t framesReceived() const;
+  uint32_t reportsSent() const;
+
+private:
+  int _master;
+  int _slave;
+  char _slaveName[64];
+  std::thread _thread;
+  std::atomic<bool> _running;
+  std::atomic<uint32_t> _framesReceived;
+  std::atomic<uint32_t> _reportsSent;
+  uint32_t _reportInterval;
+  bool _heartbeatSent;
+  TuyaFrameParser _parser;
+  TuyaWaterQualitySensor _sensor;
+
+  void run();
+  void handleFrame(const TuyaFrameView& frame);
+  void sendFrame(uint8_t command, const uint8_t* data, uint16_t length);
+  void sendStatus(const uint8_t* dataPoints, uint8_t count);
+  void drift();
+
+  TuyaMcuSimulator(const TuyaMcuSimulator&);
+  TuyaMcuSimulator& operator=(const TuyaMcuSimulator&);
+};
+
+#endif // TUYA_MCU_SIMULATOR_H
@@ -0,0 +1,86 @@
+#include "tuya_scanner.h"
+
+#include <string.h>
+#include <tuya_frame.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+static size_t findHeaderScalar(const uint8_t* data, size_t size, size_t offset) {
+  while (offset + 1 < size) {
+    const void* found = memchr(data + offset, 0x55, size - offset - 1);
+    if (found == nullptr) {
+      return size;
+    }
+    offset = static_cast<const uint8_t*>(found) - data;
+    if (data[offset + 1] == 0xAA) {
+      return offset;
+    }
+    offset++;
+  }
+  return size;
+}
+
+size_t tuyaFindHeader(const uint8_t* data, size_t size, size_t offset) {
+#if defined(__AVX2__)
+  const __m256i high = _mm256_set1_epi8(0x55);
+  const __m256i low = _mm256_set1_epi8((char)0xAA);
+  while (offset + 33 <= size) {
+    __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+    __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset + 1));
+    uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, high), _mm256_cmpeq_epi8(second, low)));
+    if (mask != 0) {
+      return offset + __builtin_ctz(mask);
+    }
+    offset += 32;
+  }
+#elif defined(__SSE2__)
+  const __m128i high = _mm_set1_epi8(0x55);
+  const __m128i low = _mm_set1_epi8((char)0xAA);
+  while (offset + 17 <= size) {
+    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+    __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + 1));
+    uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, high), _mm_cmpeq_epi8(second, low)));
+    if (mask != 0) {
+      return offset + __builtin_ctz(mask);
+    }
+    offset += 16;
+  }
+#endif
+  return findHeaderScalar(data, size, offset);
+}
+
+bool tuyaValidateFrame(const uint8_t* data, size_t size, size_t offset, uint16_t& frameSize) {
+  if (offset + TUYA_HEADER_SIZE + 1 > size) {
+    return false;
+  }
+
+  const uint8_t* frame = data + offset;
+  if (frame[0] != 0x55 || frame[1] != 0xAA) {
+    return false;
+  }
+
+  uint16_t dataLength = (frame[4] << 8) | frame[5];
+  if (dataLength > TUYA_MAX_DATA_LENGTH || offset + TUYA_HEADER_SIZE + dataLength + 1 > size) {
+    return false;
+  }
+
+  uint16_t checksumOffset = TUYA_HEADER_SIZE + dataLength;
+  if (tuyaChecksum(frame, checksumOffset) != frame[checksumOffset]) {
+    return false;
+  }
+
+  frameSize = checksumOffset + 1;
+  return true;
+}
+
+size_t tuyaFindFrame(const uint8_t* data, size_t size, size_t offset, uint16_t& frameSize) {
+  while ((offset = tuyaFindHeader(data, size, offset)) < size) {
+    if (tuyaValidateFrame(data, size, offset, frameSize)) {
+      return offset;
+    }
+    offset++;
+  }
+  return size;
+}
@@ -0,0 +1,19 @@
+#ifndef TUYA_SCANNER_H
+#define TUYA_SCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Position of the next 0x55 0xAA pair at or after offset, or size if there is
+// none. Uses AVX2 or SSE2 when the build enables them.
+size_t tuyaFindHeader(const uint8_t* data, size_t size, size_t offset);
+
+// Checks that a complete frame with a valid length and checksum starts at
+// offset. On success frameSize receives the size of the whole frame.
+bool tuyaValidateFrame(const uint8_t* data, size_t size, size_t offset, uint16_t& frameSize);
+
+// Next valid frame at or after offset: header search plus validation,
+// advancing one byte past every candidate that fails. Returns size if none.
+size_t tuyaFindFrame(const uint8_t* data, size_t size, size_t offset, uint16_t& frameSize);
+
+#endif // TUYA_SCANNER_H
@@ -0,0 +1,161 @@
+#include "tuya_bus.h"
+
+static_assert(TUYA_BUS_DEVICES <= 32, "loop(ready) takes one bit per device");
+
+TuyaBus::TuyaBus()
+  : _serials(), _count(0), _onReceiveSensor(nullptr), _onReceiveSensorContext(nullptr),
+    _onResetWiFiPairMode(nullptr), _onResetWiFiPairModeContext(nullptr), _onAlarm(nullptr), _onAlarmContext(nullptr) {
+#if defined(ESP32)
+  _task = nullptr;
+#endif
+}
+
+// Returns the id of the new device, or -1 when the bus is full. With a
+// store the device persists its state and warm-starts from it.
+int8_t TuyaBus::add(Stream* pSerial, TuyaStateStore* store) {
+  if (pSerial == nullptr || _count >= TUYA_BUS_DEVICES) {
+    return -1;
+  }
+
+  uint8_t id = _count;
+  TuyaWaterQuality& device = _devices[id];
+  device.setId(id);
+  // One flush per bus pass rather than one per device
+  device.setLogAutoFlush(false);
+  device.onReceiveSensor(sensorCallback, this);
+  device.onResetWiFiPairMode(resetCallback, this);
+  device.onAlarm(alarmCallback, this);
+  if (store != nullptr) {
+    device.persist(store);
+  }
+  device.begin(pSerial);
+
+  _serials[id] = pSerial;
+  _count++;
+  return id;
+}
+
+#if defined(ESP32)
+int8_t TuyaBus::add(HardwareSerial& serial, TuyaStateStore* store) {
+  int8_t id = add(&serial, store);
+  if (id < 0) {
+    return id;
+  }
+
+  // Runs in the UART driver's event task, only wake the bus from there
+  serial.onReceive([this]() {
+    TaskHandle_t task = _task;
+    if (task != nullptr) {
+      xTaskNotifyGive(task);
+    }
+  });
+  return id;
+}
+#endif
+
+uint8_t TuyaBus::size() const {
+  return _count;
+}
+
+// nullptr for an id add() never returned
+TuyaWaterQuality* TuyaBus::device(uint8_t id) {
+  return id < _count ? &_devices[id] : nullptr;
+}
+
+void TuyaBus::debug(Stream& stream, bool enable) {
+  tuyaDefaultLog().setOutput(enable ? &stream : nullptr);
+}
+
+TuyaLog& TuyaBus::logger() {
+  return tuyaDefaultLog();
+}
+
+void TuyaBus::onReceiveSensor(TuyaBusSensorCallback callback, void* context) {
+  _onReceiveSensor = callback;
+  _onReceiveSensorContext = context;
+}
+
+void TuyaBus::onResetWiFiPairMode(TuyaBusResetCallback callback, void* context) {
+  _onResetWiFiPairMode = callback;
+  _onResetWiFiPairModeContext = context;
+}
+
+void TuyaBus::onAlarm(TuyaBusAlarmCallback callback, void* context) {
+  _onAlarm = callback;
+  _onAlarmContext = context;
+}
+
+uint32_t TuyaBus::timeUntilNext() {
+  uint32_t wait = UINT32_MAX;
+  for (uint8_t i = 0; i < _count; i++) {
+    uint32_t next = _devices[i].timeUntilNext();
+    if (next < wait) {
+      wait = next;
+    }
+  }
+  return wait;
+}
+
+// Polls every stream for unread input, cheap on a UART but a syscall per
+// port on a host; there, use loop(ready) with what epoll reported
+uint8_t TuyaBus::loop() {
+  uint32_t ready = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_serials[i]->available() > 0) {
+      ready |= 1UL << i;
+    }
+  }
+  return loop(ready);
+}
+
+// Runs the devices whose bit is set in ready and those with a due timer,
+// without touching any other stream, then formats a few log records.
+// Returns the number of devices that ran.
+uint8_t TuyaBus::loop(uint32_t ready) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if ((ready & (1UL << i)) != 0 || _devices[i].timeUntilNext() == 0) {
+      _devices[i].loop();
+      count++;
+    }
+  }
+  tuyaDefaultLog().flush(TUYA_LOG_FLUSH_RECORDS);
+  return count;
+}
+
+// Sleeps for at most maxWait ms, or until input arrives or a timer is due,
+// then runs loop(). Without a UART wakeup it only polls.
+uint8_t TuyaBus::run(uint32_t maxWait) {
+#if defined(ESP32)
+  _task = xTaskGetCurrentTaskHandle();
+  uint32_t wait = timeUntilNext();
+  if (wait > maxWait) {
+    wait = maxWait;
+  }
+  if (wait > 0) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+  }
+#endif
+  return loop();
+}
+
+void TuyaBus::sensorCallback(TuyaWaterQuality& device, TuyaWaterQualitySensor& sensor, uint16_t fields, void* context) {
+  TuyaBus* bus = static_cast<TuyaBus*>(context);
+  if (bus->_onReceiveSensor != nullptr) {
+    bus->_onReceiveSensor(device.getId(), sensor, fields, bus->_onReceiveSensorContext);
+  }
+}
+
+void TuyaBus::resetCallback(Tuya& device, void* context) {
+  TuyaBus* bus = static_cast<TuyaBus*>(context);
+  if (bus->_onResetWiFiPairMode != nullptr) {
+    bus->_onResetWiFiPairMode(device.getId(), bus->_onResetWiFiPairModeContext);
+  }
+}
+
+void TuyaBus::alarmCallback(TuyaWaterQuality& device, const TuyaAlarmEvent& event, void* context) {
+  TuyaBus* bus = static_cast<TuyaBus*>(context);
+  if (bus->_onAlarm != nullptr) {
+    bus->_onAlarm(device.getId(), event, bus->_onAlarmContext);
+  }
+}
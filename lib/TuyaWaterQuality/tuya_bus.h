@@ -0,0 +1,74 @@
+#ifndef TUYA_BUS_H
+#define TUYA_BUS_H
+
+#include <Arduino.h>
+#include <Stream.h>
+#include "tuya_water_quality.h"
+
+// Three UARTs on an ESP32, a gateway on Linux can run a few dozen
+#ifndef TUYA_BUS_DEVICES
+#if defined(ESP32)
+#define TUYA_BUS_DEVICES 3
+#else
+#define TUYA_BUS_DEVICES 16
+#endif
+#endif
+
+typedef void (*TuyaBusSensorCallback)(uint8_t device, TuyaWaterQualitySensor& sensor, uint16_t fields, void* context);
+typedef void (*TuyaBusResetCallback)(uint8_t device, void* context);
+typedef void (*TuyaBusAlarmCallback)(uint8_t device, const TuyaAlarmEvent& event, void* context);
+
+// Several water quality MCUs driven from one thread. The devices write into
+// tuyaDefaultLog() tagged with their id, and every callback reports the id of the
+// device it came from.
+//
+// loop() only runs the devices that have input or a due timer. On ESP32,
+// run() sleeps until a UART added with add(HardwareSerial&) receives data or
+// the earliest timer is due. Linux hosts wait in TuyaEventLoop::wait()
+// instead and pass the devices it found readable to loop(ready), so idle
+// ports are never read.
+class TuyaBus {
+public:
+  TuyaBus();
+
+  int8_t add(Stream* pSerial, TuyaStateStore* store = nullptr);
+#if defined(ESP32)
+  int8_t add(HardwareSerial& serial, TuyaStateStore* store = nullptr);
+#endif
+  uint8_t size() const;
+  TuyaWaterQuality* device(uint8_t id);
+
+  void debug(Stream& stream, bool enable);
+  TuyaLog& logger();
+  void onReceiveSensor(TuyaBusSensorCallback callback, void* context = nullptr);
+  void onResetWiFiPairMode(TuyaBusResetCallback callback, void* context = nullptr);
+  void onAlarm(TuyaBusAlarmCallback callback, void* context = nullptr);
+
+  uint32_t timeUntilNext();
+  uint8_t loop();
+  uint8_t loop(uint32_t ready);
+  uint8_t run(uint32_t maxWait);
+
+private:
+  TuyaWaterQuality _devices[TUYA_BUS_DEVICES];
+  Stream* _serials[TUYA_BUS_DEVICES];
+  uint8_t _count;
+  TuyaBusSensorCallback _onReceiveSensor;
+  void* _onReceiveSensorContext;
+  TuyaBusResetCallback _onResetWiFiPairMode;
+  void* _onResetWiFiPairModeContext;
+  TuyaBusAlarmCallback _onAlarm;
+  void* _onAlarmContext;
+#if defined(ESP32)
+  TaskHandle_t volatile _task;
+#endif
+
+  static void sensorCallback(TuyaWaterQuality& device, TuyaWaterQualitySensor& sensor, uint16_t fields, void* context);
+  static void resetCallback(Tuya& device, void* context);
+  static void alarmCallback(TuyaWaterQuality& device, const TuyaAlarmEvent& event, void* context);
+
+  TuyaBus(const TuyaBus&);
+  TuyaBus& operator=(const TuyaBus&);
+};
+
+#endif // TUYA_BUS_H
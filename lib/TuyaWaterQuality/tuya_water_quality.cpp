@@ -1,19 +1,63 @@
 #include "tuya_water_quality.h"
 
-TuyaWaterQuality::TuyaWaterQuality() : Tuya() {
+// Default lengths of WINDOW_MINUTE and WINDOW_HOUR in ms
+static const uint32_t historyWindows[2] = { 60000, 3600000 };
+
+struct TuyaWaterQualityLimit {
+  uint8_t value;
+  uint8_t threshold;
+  bool high;
+};
+
+// Indexed by TuyaWaterQualityAlarm
+static const TuyaWaterQualityLimit alarmLimits[TUYA_WATER_QUALITY_ALARMS] = {
+  { DP_TEMPERATURE, DP_HIGH_TEMPERATURE_THRESHOLD, true },
+  { DP_TEMPERATURE, DP_LOW_TEMPERATURE_THRESHOLD, false },
+  { DP_PH, DP_HIGH_PH_THRESHOLD, true },
+  { DP_PH, DP_LOW_PH_THRESHOLD, false },
+  { DP_TDS, DP_HIGH_TDS_THRESHOLD, true },
+  { DP_TDS, DP_LOW_TDS_THRESHOLD, false },
+};
+
+TuyaWaterQuality::TuyaWaterQuality()
+  : Tuya(), _temperatureHistory(historyWindows), _phHistory(historyWindows), _tdsHistory(historyWindows),
+    _writes(), _filterTimer(TUYA_INVALID_TIMER), _onAlarm(nullptr), _onAlarmContext(nullptr) {
   _onReceiveSensor = nullptr;
+  _onReceiveSensorDevice = nullptr;
+  _onReceiveSensorContext = nullptr;
+  _reportedFields = 0;
   _sensorData = {
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
+    {0, 0, 0, waterQualityDataPoints.find(DP_TEMPERATURE)->decimals},
+    {0, 0, 0, waterQualityDataPoints.find(DP_PH)->decimals},
+    {0, 0, 0, waterQualityDataPoints.find(DP_TDS)->decimals},
   };
 }
 
-double TuyaWaterQuality::getTemperature() {
+// Every value and threshold has been reported, the getters no longer return
+// placeholders
+bool TuyaWaterQuality::isReady() const {
+  static constexpr uint16_t allFields = waterQualityDataPoints.fields();
+  return isInitialized() && (_reportedFields & allFields) == allFields;
+}
+
+// A status report with this many DPs answers the bulk query
+uint8_t TuyaWaterQuality::dataPointCount() const {
+  return waterQualityDataPoints.size();
+}
+
+float TuyaWaterQuality::getTemperature() {
+  return tuyaFixedToFloat(_sensorData.temperature.value, _sensorData.temperature.decimals);
+}
+
+int32_t TuyaWaterQuality::getTemperatureRaw() {
   return _sensorData.temperature.value;
 }
 
-double TuyaWaterQuality::getPH() {
+float TuyaWaterQuality::getPH() {
+  return tuyaFixedToFloat(_sensorData.ph.value, _sensorData.ph.decimals);
+}
+
+int32_t TuyaWaterQuality::getPHRaw() {
   return _sensorData.ph.value;
 }
 
@@ -21,36 +65,52 @@ int32_t TuyaWaterQuality::getTDS() {
   return _sensorData.tds.value;
 }
 
-double TuyaWaterQuality::getMaxTemperature() {
+float TuyaWaterQuality::getMaxTemperature() {
+  return tuyaFixedToFloat(_sensorData.temperature.MaxThreshold, _sensorData.temperature.decimals);
+}
+
+int32_t TuyaWaterQuality::getMaxTemperatureRaw() {
   return _sensorData.temperature.MaxThreshold;
 }
 
 bool TuyaWaterQuality::setMaxTemperature(int32_t value) {
-  return setThreshold(DP_HIGH_TEMPERATURE_THRESHOLD, value);
+  return setThreshold<DP_HIGH_TEMPERATURE_THRESHOLD>(value);
+}
+
+float TuyaWaterQuality::getMinTemperature() {
+  return tuyaFixedToFloat(_sensorData.temperature.MinThreshold, _sensorData.temperature.decimals);
 }
 
-double TuyaWaterQuality::getMinTemperature() {
+int32_t TuyaWaterQuality::getMinTemperatureRaw() {
   return _sensorData.temperature.MinThreshold;
 }
 
 bool TuyaWaterQuality::setMinTemperature(int32_t value) {
-  return setThreshold(DP_LOW_TEMPERATURE_THRESHOLD, value);
+  return setThreshold<DP_LOW_TEMPERATURE_THRESHOLD>(value);
+}
+
+float TuyaWaterQuality::getMaxPH() {
+  return tuyaFixedToFloat(_sensorData.ph.MaxThreshold, _sensorData.ph.decimals);
 }
 
-double TuyaWaterQuality::getMaxPH() {
+int32_t TuyaWaterQuality::getMaxPHRaw() {
   return _sensorData.ph.MaxThreshold;
 }
 
 bool TuyaWaterQuality::setMaxPH(int32_t value) {
-  return setThreshold(DP_HIGH_PH_THRESHOLD, value);
+  return setThreshold<DP_HIGH_PH_THRESHOLD>(value);
+}
+
+float TuyaWaterQuality::getMinPH() {
+  return tuyaFixedToFloat(_sensorData.ph.MinThreshold, _sensorData.ph.decimals);
 }
 
-double TuyaWaterQuality::getMinPH() {
+int32_t TuyaWaterQuality::getMinPHRaw() {
   return _sensorData.ph.MinThreshold;
 }
 
 bool TuyaWaterQuality::setMinPH(int32_t value) {
-  return setThreshold(DP_LOW_PH_THRESHOLD, value);
+  return setThreshold<DP_LOW_PH_THRESHOLD>(value);
 }
 
 int32_t TuyaWaterQuality::getMaxTDS() {
@@ -58,7 +118,7 @@ int32_t TuyaWaterQuality::getMaxTDS() {
 }
 
 bool TuyaWaterQuality::setMaxTDS(int32_t value) {
-  return setThreshold(DP_HIGH_TDS_THRESHOLD, value);
+  return setThreshold<DP_HIGH_TDS_THRESHOLD>(value);
 }
 
 int32_t TuyaWaterQuality::getMinTDS() {
@@ -66,85 +126,361 @@ int32_t TuyaWaterQuality::getMinTDS() {
 }
 
 bool TuyaWaterQuality::setMinTDS(int32_t value) {
-  return setThreshold(DP_LOW_TDS_THRESHOLD, value);
+  return setThreshold<DP_LOW_TDS_THRESHOLD>(value);
 }
 
-void TuyaWaterQuality::onReceiveSensor(void (*callback)(TuyaWaterQualitySensor& sensor)) {
-  _onReceiveSensor = callback;
+TuyaWaterQualityThresholds TuyaWaterQuality::beginThresholds() {
+  return TuyaWaterQualityThresholds(*this);
 }
 
-// Private methods
-bool TuyaWaterQuality::decodeReportStatusAsync(TuyaFrame& frame) {
-  TuyaDataType dataType = static_cast<TuyaDataType>(frame.data[1]);
-  if (dataType != DT_VALUE) {
+// Rollup in raw fixed-point units, the same cost whatever the window length
+bool TuyaWaterQuality::getHistoryStats(TuyaWaterQualityDataPoint dataPoint, TuyaWaterQualityWindow window, TuyaHistoryStats& stats) const {
+  const TuyaWaterQualityHistory* history = getHistory(dataPoint);
+  if (history == nullptr) {
     return false;
   }
+  return history->stats(window, millis(), stats);
+}
+
+bool TuyaWaterQuality::setHistoryWindow(TuyaWaterQualityWindow window, uint32_t length) {
+  return _temperatureHistory.setWindow(window, length)
+    && _phHistory.setWindow(window, length)
+    && _tdsHistory.setWindow(window, length);
+}
 
-  TuyaWaterQualityDataPoint dpId = static_cast<TuyaWaterQualityDataPoint>(frame.data[0]);
-  switch (dpId) {
+const TuyaWaterQualityHistory* TuyaWaterQuality::getHistory(TuyaWaterQualityDataPoint dataPoint) const {
+  switch (dataPoint) {
   case DP_TEMPERATURE:
-    _sensorData.temperature.value = decodeSensorRawValue(frame.data) / 10.0;
-    break;
-  case DP_HIGH_TEMPERATURE_THRESHOLD:
-    _sensorData.temperature.MaxThreshold = decodeSensorRawValue(frame.data) / 10.0;
-    break;
-  case DP_LOW_TEMPERATURE_THRESHOLD:
-    _sensorData.temperature.MinThreshold = decodeSensorRawValue(frame.data) / 10.0;
-    break;
+    return &_temperatureHistory;
   case DP_PH:
-    _sensorData.ph.value = decodeSensorRawValue(frame.data) / 100.0;
-    break;
-  case DP_HIGH_PH_THRESHOLD:
-    _sensorData.ph.MaxThreshold = decodeSensorRawValue(frame.data) / 100.0;
-    break;
-  case DP_LOW_PH_THRESHOLD:
-    _sensorData.ph.MinThreshold = decodeSensorRawValue(frame.data) / 100.0;
-    break;
+    return &_phHistory;
   case DP_TDS:
-    _sensorData.tds.value = decodeSensorRawValue(frame.data);
-    break;
-  case DP_HIGH_TDS_THRESHOLD:
-    _sensorData.tds.MaxThreshold = decodeSensorRawValue(frame.data);
-    break;
-  case DP_LOW_TDS_THRESHOLD:
-    _sensorData.tds.MinThreshold = decodeSensorRawValue(frame.data);
-    break;
+    return &_tdsHistory;
   default:
+    return nullptr;
+  }
+}
+
+void TuyaWaterQuality::onReceiveSensor(void (*callback)(TuyaWaterQualitySensor& sensor, uint16_t fields)) {
+  _onReceiveSensor = callback;
+}
+
+// For callbacks shared by several devices, getId() tells them apart
+void TuyaWaterQuality::onReceiveSensor(void (*callback)(TuyaWaterQuality& device, TuyaWaterQualitySensor& sensor,
+  uint16_t fields, void* context), void* context) {
+  _onReceiveSensorDevice = callback;
+  _onReceiveSensorContext = context;
+}
+
+// Filters apply before onReceiveSensor; a DP without a filter notifies on every report
+bool TuyaWaterQuality::setNotifyFilter(TuyaWaterQualityDataPoint dataPoint, const TuyaNotifyFilter& config) {
+  TuyaChangeFilter* target = filter(dataPoint);
+  if (target == nullptr) {
     return false;
   }
 
-  if (_onReceiveSensor != nullptr) {
-    _onReceiveSensor(_sensorData);
+  target->configure(config);
+  if (_filterTimer == TUYA_INVALID_TIMER) {
+    _filterTimer = everyInternal(TUYA_NOTIFY_POLL_INTERVAL, filterTask, this);
+  }
+  return true;
+}
+
+bool TuyaWaterQuality::clearNotifyFilter(TuyaWaterQualityDataPoint dataPoint) {
+  TuyaChangeFilter* target = filter(dataPoint);
+  if (target == nullptr) {
+    return false;
+  }
+  target->disable();
+  return true;
+}
+
+void TuyaWaterQuality::onAlarm(void (*callback)(TuyaWaterQuality& device, const TuyaAlarmEvent& event,
+  void* context), void* context) {
+  _onAlarm = callback;
+  _onAlarmContext = context;
+}
+
+// Alarms run with no hysteresis and no debounce until configured
+bool TuyaWaterQuality::setAlarmConfig(TuyaWaterQualityAlarm alarm, const TuyaAlarmConfig& config) {
+  if (alarm >= TUYA_WATER_QUALITY_ALARMS) {
+    return false;
+  }
+  _alarms[alarm].configure(config);
+  return true;
+}
+
+const TuyaAlarm* TuyaWaterQuality::getAlarm(TuyaWaterQualityAlarm alarm) const {
+  return alarm < TUYA_WATER_QUALITY_ALARMS ? &_alarms[alarm] : nullptr;
+}
+
+// Private methods
+bool TuyaWaterQuality::decodeReportStatusAsync(const TuyaFrameView& frame) {
+  static constexpr uint16_t thresholdFields = waterQualityDataPoints.writableFields();
+  TuyaWaterQualitySensor previous = _sensorData;
+  uint16_t fields = 0;
+  TuyaDataPoint dataPoint;
+  TuyaDataPointReader reader(frame);
+  while (reader.next(dataPoint)) {
+    fields |= waterQualityDataPoints.decode(_sensorData, dataPoint);
+  }
+
+  if (fields == 0) {
+    return false;
+  }
+  // Only new thresholds are worth an immediate flash write
+  if (thresholdsChanged(previous, fields & thresholdFields)) {
+    stateChanged();
+  }
+  if ((fields & ~thresholdFields) != 0) {
+    readingsChanged();
+  }
+  settleWrites(fields & thresholdFields);
+  _reportedFields |= fields;
+  recordHistory(fields);
+  uint32_t now = millis();
+  evaluateAlarms(fields, now);
+  notifySensor(filterFields(fields, now));
+
+  return true;
+}
+
+// Reported fields, then the wire value of every DP in table order
+bool TuyaWaterQuality::saveState(TuyaSnapshotWriter& writer) const {
+  writer.putU16(_reportedFields);
+  for (uint8_t i = 0; i < waterQualityDataPoints.size(); i++) {
+    writer.putI32(waterQualityDataPoints.value(_sensorData, waterQualityDataPoints[i]));
+  }
+  return true;
+}
+
+bool TuyaWaterQuality::restoreState(TuyaSnapshotReader& reader) {
+  TuyaWaterQualitySensor sensorData = _sensorData;
+  uint16_t reportedFields = reader.getU16();
+  for (uint8_t i = 0; i < waterQualityDataPoints.size(); i++) {
+    waterQualityDataPoints.setValue(sensorData, waterQualityDataPoints[i], reader.getI32());
+  }
+  if (reader.failed() || reader.remaining() != 0) {
+    return false;
   }
 
+  _sensorData = sensorData;
+  _reportedFields = reportedFields & waterQualityDataPoints.fields();
   return true;
 }
 
-uint32_t TuyaWaterQuality::decodeSensorRawValue(uint8_t* data) {
-  return (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+bool TuyaWaterQuality::isReported(uint8_t dataPoint, int32_t value) const {
+  const TuyaDpDescriptor<TuyaWaterQualitySensor>* descriptor = waterQualityDataPoints.find(dataPoint);
+  if (descriptor == nullptr || !(_reportedFields & descriptor->field)) {
+    return false;
+  }
+  return waterQualityDataPoints.matches(_sensorData, dataPoint, value);
 }
 
-bool TuyaWaterQuality::setThreshold(TuyaWaterQualityDataPoint datapoint, int32_t value) {
-  uint8_t data[8];
-  if (!generateSensorData(data, datapoint, value)) {
+// True while value was sent for dataPoint and its echo is not overdue
+bool TuyaWaterQuality::isPending(uint8_t dataPoint, int32_t value, uint32_t now) const {
+  const TuyaDpDescriptor<TuyaWaterQualitySensor>* descriptor = waterQualityDataPoints.find(dataPoint);
+  if (descriptor == nullptr) {
     return false;
   }
+  const TuyaThresholdWrite& write = _writes[descriptor - &waterQualityDataPoints[0]];
+  return write.pending && write.value == value && now - write.sentAt < TUYA_THRESHOLD_WRITE_TIMEOUT;
+}
+
+// An echo of the sent value completes the write. A clamped or different echo
+// leaves it pending, so the value is only retried once the timeout expires.
+void TuyaWaterQuality::settleWrites(uint16_t fields) {
+  for (uint8_t i = 0; i < waterQualityDataPoints.size() && fields != 0; i++) {
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>& descriptor = waterQualityDataPoints[i];
+    if ((fields & descriptor.field) && _writes[i].pending &&
+        waterQualityDataPoints.value(_sensorData, descriptor) == _writes[i].value) {
+      _writes[i].pending = false;
+    }
+  }
+}
+
+// True if a threshold in fields was not reported before or now differs
+bool TuyaWaterQuality::thresholdsChanged(const TuyaWaterQualitySensor& previous, uint16_t fields) const {
+  for (uint8_t i = 0; i < waterQualityDataPoints.size() && fields != 0; i++) {
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>& descriptor = waterQualityDataPoints[i];
+    if ((fields & descriptor.field) == 0) {
+      continue;
+    }
+    if ((_reportedFields & descriptor.field) == 0 ||
+        waterQualityDataPoints.value(previous, descriptor) != waterQualityDataPoints.value(_sensorData, descriptor)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TuyaWaterQuality::recordHistory(uint16_t fields) {
+  uint32_t now = millis();
+  if (fields & FIELD_TEMPERATURE) {
+    _temperatureHistory.add(now, _sensorData.temperature.value);
+  }
+  if (fields & FIELD_PH) {
+    _phHistory.add(now, _sensorData.ph.value);
+  }
+  if (fields & FIELD_TDS) {
+    _tdsHistory.add(now, _sensorData.tds.value);
+  }
+}
+
+TuyaChangeFilter* TuyaWaterQuality::filter(uint8_t dataPoint) {
+  const TuyaDpDescriptor<TuyaWaterQualitySensor>* descriptor = waterQualityDataPoints.find(dataPoint);
+  if (descriptor == nullptr) {
+    return nullptr;
+  }
+  return &_filters[descriptor - &waterQualityDataPoints[0]];
+}
+
+uint16_t TuyaWaterQuality::filterFields(uint16_t fields, uint32_t now) {
+  uint16_t notify = 0;
+  for (uint8_t i = 0; i < waterQualityDataPoints.size(); i++) {
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>& descriptor = waterQualityDataPoints[i];
+    if ((fields & descriptor.field) && _filters[i].report(waterQualityDataPoints.value(_sensorData, descriptor), now)) {
+      notify |= descriptor.field;
+    }
+  }
+  return notify;
+}
+
+void TuyaWaterQuality::notifySensor(uint16_t fields) {
+  if (fields == 0) {
+    return;
+  }
+  if (_onReceiveSensor != nullptr) {
+    _onReceiveSensor(_sensorData, fields);
+  }
+  if (_onReceiveSensorDevice != nullptr) {
+    _onReceiveSensorDevice(*this, _sensorData, fields, _onReceiveSensorContext);
+  }
+}
+
+// Runs the alarms whose value or threshold the frame updated, once both have
+// been reported
+void TuyaWaterQuality::evaluateAlarms(uint16_t fields, uint32_t now) {
+  for (uint8_t i = 0; i < TUYA_WATER_QUALITY_ALARMS; i++) {
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>& value = *waterQualityDataPoints.find(alarmLimits[i].value);
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>& threshold = *waterQualityDataPoints.find(alarmLimits[i].threshold);
+    uint16_t limitFields = value.field | threshold.field;
+    if (!(fields & limitFields) || (_reportedFields & limitFields) != limitFields) {
+      continue;
+    }
+
+    TuyaAlarmEvent event;
+    event.alarm = static_cast<TuyaWaterQualityAlarm>(i);
+    event.value = waterQualityDataPoints.value(_sensorData, value);
+    event.threshold = waterQualityDataPoints.value(_sensorData, threshold);
+    int32_t excess = alarmLimits[i].high ? event.value - event.threshold : event.threshold - event.value;
+    // Only a new reading is a sample for the debounce, a new threshold just
+    // re-checks the last one
+    event.edge = (fields & value.field) ? _alarms[i].evaluate(excess, now) : _alarms[i].recheck(excess, now);
+    if (event.edge == ALARM_NONE || _onAlarm == nullptr) {
+      continue;
+    }
+    event.duration = event.edge == ALARM_CLEARED ? _alarms[i].duration(now) : 0;
+    _onAlarm(*this, event, _onAlarmContext);
+  }
+}
 
-  TuyaFrame frame = generateFrame(MODULE, SEND_COMMAND, data, 8);
-  return sendFrame(frame);
+// Publishes changes held back by a minimum interval and silence heartbeats
+void TuyaWaterQuality::filterTask(void* context) {
+  TuyaWaterQuality* device = static_cast<TuyaWaterQuality*>(context);
+  uint32_t now = millis();
+  uint16_t notify = 0;
+  for (uint8_t i = 0; i < waterQualityDataPoints.size(); i++) {
+    if (device->_filters[i].poll(now)) {
+      notify |= waterQualityDataPoints[i].field;
+    }
+  }
+  device->notifySensor(notify);
 }
 
-bool TuyaWaterQuality::generateSensorData(uint8_t(&buffer)[8], TuyaWaterQualityDataPoint dataPoint, int32_t value) {
-  const int VALUE_LENGTH = 4;
+bool TuyaWaterQuality::sendThresholds(const uint8_t* dataPoints, const int32_t* values, uint8_t count) {
+  uint8_t data[TUYA_FRAME_BUFFER_SIZE - TUYA_HEADER_SIZE - 1];
+  uint16_t length = 0;
+  uint8_t sent[waterQualityDataPoints.size()];
+  uint8_t sentCount = 0;
+  uint32_t now = millis();
+  if (count > sizeof(sent)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    if (isReported(dataPoints[i], values[i]) || isPending(dataPoints[i], values[i], now)) {
+      continue;
+    }
+
+    uint16_t written = waterQualityDataPoints.encode(data + length, sizeof(data) - length, dataPoints[i], values[i]);
+    if (written == 0) {
+      return false;
+    }
+    length += written;
+    sent[sentCount++] = i;
+  }
 
-  buffer[0] = dataPoint;
-  buffer[1] = DT_VALUE;
-  buffer[2] = (VALUE_LENGTH >> 8) & 0xFF;
-  buffer[3] = VALUE_LENGTH & 0xFF;
-  buffer[4] = (value >> 24) & 0xFF;
-  buffer[5] = (value >> 16) & 0xFF;
-  buffer[6] = (value >> 8) & 0xFF;
-  buffer[7] = value & 0xFF;
+  if (length == 0) {
+    return true;
+  }
+  if (!sendFrame(generateFrame(MODULE, SEND_COMMAND, data, length))) {
+    return false;
+  }
 
+  for (uint8_t i = 0; i < sentCount; i++) {
+    const TuyaDpDescriptor<TuyaWaterQualitySensor>* descriptor = waterQualityDataPoints.find(dataPoints[sent[i]]);
+    _writes[descriptor - &waterQualityDataPoints[0]] = { values[sent[i]], now, true };
+  }
   return true;
+}
+
+// TuyaWaterQualityThresholds
+TuyaWaterQualityThresholds::TuyaWaterQualityThresholds(TuyaWaterQuality& device)
+  : _device(device), _count(0) {
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::setMaxTemperature(int32_t value) {
+  return set(DP_HIGH_TEMPERATURE_THRESHOLD, value);
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::setMinTemperature(int32_t value) {
+  return set(DP_LOW_TEMPERATURE_THRESHOLD, value);
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::setMaxPH(int32_t value) {
+  return set(DP_HIGH_PH_THRESHOLD, value);
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::setMinPH(int32_t value) {
+  return set(DP_LOW_PH_THRESHOLD, value);
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::setMaxTDS(int32_t value) {
+  return set(DP_HIGH_TDS_THRESHOLD, value);
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::setMinTDS(int32_t value) {
+  return set(DP_LOW_TDS_THRESHOLD, value);
+}
+
+bool TuyaWaterQualityThresholds::commit() {
+  bool sent = _device.sendThresholds(_dataPoints, _values, _count);
+  _count = 0;
+  return sent;
+}
+
+TuyaWaterQualityThresholds& TuyaWaterQualityThresholds::set(TuyaWaterQualityDataPoint dataPoint, int32_t value) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_dataPoints[i] == dataPoint) {
+      _values[i] = value;
+      return *this;
+    }
+  }
+
+  if (_count < sizeof(_dataPoints)) {
+    _dataPoints[_count] = dataPoint;
+    _values[_count] = value;
+    _count++;
+  }
+  return *this;
 }
\ No newline at end of file
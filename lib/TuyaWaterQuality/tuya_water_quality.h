@@ -4,6 +4,23 @@
 #include <Arduino.h>
 #include <Stream.h>
 #include <tuya.h>
+#include <tuya_static_frame.h>
+#include <tuya_dp_registry.h>
+#include <tuya_history.h>
+#include <tuya_change_filter.h>
+#include <tuya_alarm.h>
+
+#ifndef TUYA_HISTORY_SIZE
+#define TUYA_HISTORY_SIZE 256
+#endif
+
+#define TUYA_NOTIFY_POLL_INTERVAL 100
+
+// Milliseconds a threshold write waits for its echo before commit() sends it again
+#ifndef TUYA_THRESHOLD_WRITE_TIMEOUT
+#define TUYA_THRESHOLD_WRITE_TIMEOUT 30000
+#endif
+#define TUYA_WATER_QUALITY_ALARMS 6
 
 // Enums for Tuya Water Quality Data Points
 enum TuyaWaterQualityDataPoint {
@@ -18,11 +35,53 @@ enum TuyaWaterQualityDataPoint {
   DP_LOW_TDS_THRESHOLD = 0x71,
 };
 
+// Bitmask of the sensor fields updated by a status frame
+enum TuyaWaterQualityField {
+  FIELD_TEMPERATURE = 1 << 0,
+  FIELD_MAX_TEMPERATURE = 1 << 1,
+  FIELD_MIN_TEMPERATURE = 1 << 2,
+  FIELD_PH = 1 << 3,
+  FIELD_MAX_PH = 1 << 4,
+  FIELD_MIN_PH = 1 << 5,
+  FIELD_TDS = 1 << 6,
+  FIELD_MAX_TDS = 1 << 7,
+  FIELD_MIN_TDS = 1 << 8,
+};
+
+// Rollup windows kept for every measured value
+enum TuyaWaterQualityWindow {
+  WINDOW_MINUTE = 0,
+  WINDOW_HOUR = 1,
+};
+
+typedef TuyaSensorHistory<TUYA_HISTORY_SIZE, 2> TuyaWaterQualityHistory;
+
+// Readings checked against the MCU's own thresholds
+enum TuyaWaterQualityAlarm {
+  ALARM_TEMPERATURE_HIGH = 0,
+  ALARM_TEMPERATURE_LOW = 1,
+  ALARM_PH_HIGH = 2,
+  ALARM_PH_LOW = 3,
+  ALARM_TDS_HIGH = 4,
+  ALARM_TDS_LOW = 5,
+};
+
+// Structs for alarm edges. Values are in wire units; duration is how long
+// the alarm was raised and only set when it clears.
+struct TuyaAlarmEvent {
+  TuyaWaterQualityAlarm alarm;
+  TuyaAlarmEdge edge;
+  int32_t value;
+  int32_t threshold;
+  uint32_t duration;
+};
+
 // Structs for Sensor Data
 struct SensorData {
-  double value;
-  double MaxThreshold;
-  double MinThreshold;
+  int32_t value;
+  int32_t MaxThreshold;
+  int32_t MinThreshold;
+  uint8_t decimals;
 };
 
 struct TuyaWaterQualitySensor {
@@ -31,31 +90,87 @@ struct TuyaWaterQualitySensor {
   SensorData tds;
 };
 
+// Data point table for the water quality MCU
+inline constexpr TuyaDpRegistry<TuyaWaterQualitySensor, 9> waterQualityDataPoints({
+  { DP_TEMPERATURE, DT_VALUE, 1, FIELD_TEMPERATURE, offsetof(TuyaWaterQualitySensor, temperature.value), false },
+  { DP_HIGH_TEMPERATURE_THRESHOLD, DT_VALUE, 1, FIELD_MAX_TEMPERATURE, offsetof(TuyaWaterQualitySensor, temperature.MaxThreshold), true },
+  { DP_LOW_TEMPERATURE_THRESHOLD, DT_VALUE, 1, FIELD_MIN_TEMPERATURE, offsetof(TuyaWaterQualitySensor, temperature.MinThreshold), true },
+  { DP_PH, DT_VALUE, 2, FIELD_PH, offsetof(TuyaWaterQualitySensor, ph.value), false },
+  { DP_HIGH_PH_THRESHOLD, DT_VALUE, 2, FIELD_MAX_PH, offsetof(TuyaWaterQualitySensor, ph.MaxThreshold), true },
+  { DP_LOW_PH_THRESHOLD, DT_VALUE, 2, FIELD_MIN_PH, offsetof(TuyaWaterQualitySensor, ph.MinThreshold), true },
+  { DP_TDS, DT_VALUE, 0, FIELD_TDS, offsetof(TuyaWaterQualitySensor, tds.value), false },
+  { DP_HIGH_TDS_THRESHOLD, DT_VALUE, 0, FIELD_MAX_TDS, offsetof(TuyaWaterQualitySensor, tds.MaxThreshold), true },
+  { DP_LOW_TDS_THRESHOLD, DT_VALUE, 0, FIELD_MIN_TDS, offsetof(TuyaWaterQualitySensor, tds.MinThreshold), true },
+});
+
 struct TuyaWaterQualityInformation {
-  String productId;
-  String version;
+  char productId[TUYA_PRODUCT_ID_SIZE];
+  char version[TUYA_VERSION_SIZE];
   uint16_t operationMode;
 };
 
+class TuyaWaterQuality;
+
+// Threshold value sent to the MCU and not yet echoed back
+struct TuyaThresholdWrite {
+  int32_t value;
+  uint32_t sentAt;
+  bool pending;
+};
+
+// Batch of threshold writes. commit() drops values the MCU already reported
+// or that are still waiting for their echo, and sends the rest as one
+// SEND_COMMAND frame.
+class TuyaWaterQualityThresholds {
+public:
+  TuyaWaterQualityThresholds& setMaxTemperature(int32_t value);
+  TuyaWaterQualityThresholds& setMinTemperature(int32_t value);
+  TuyaWaterQualityThresholds& setMaxPH(int32_t value);
+  TuyaWaterQualityThresholds& setMinPH(int32_t value);
+  TuyaWaterQualityThresholds& setMaxTDS(int32_t value);
+  TuyaWaterQualityThresholds& setMinTDS(int32_t value);
+
+  bool commit();
+
+private:
+  friend class TuyaWaterQuality;
+
+  TuyaWaterQuality& _device;
+  uint8_t _dataPoints[6];
+  int32_t _values[6];
+  uint8_t _count;
+
+  TuyaWaterQualityThresholds(TuyaWaterQuality& device);
+  TuyaWaterQualityThresholds& set(TuyaWaterQualityDataPoint dataPoint, int32_t value);
+};
+
 // TuyaWaterQuality class definition
 class TuyaWaterQuality : public Tuya {
 public:
   TuyaWaterQuality();
 
-  double getTemperature();
-  double getPH();
+  bool isReady() const override;
+
+  float getTemperature();
+  int32_t getTemperatureRaw();
+  float getPH();
+  int32_t getPHRaw();
   int32_t getTDS();
 
-  double getMaxTemperature();
+  float getMaxTemperature();
+  int32_t getMaxTemperatureRaw();
   bool setMaxTemperature(int32_t value);
 
-  double getMinTemperature();
+  float getMinTemperature();
+  int32_t getMinTemperatureRaw();
   bool setMinTemperature(int32_t value);
 
-  double getMaxPH();
+  float getMaxPH();
+  int32_t getMaxPHRaw();
   bool setMaxPH(int32_t value);
 
-  double getMinPH();
+  float getMinPH();
+  int32_t getMinPHRaw();
   bool setMinPH(int32_t value);
 
   int32_t getMaxTDS();
@@ -64,16 +179,67 @@ public:
   int32_t getMinTDS();
   bool setMinTDS(int32_t value);
 
-  void onReceiveSensor(void (*callback)(TuyaWaterQualitySensor& sensor));
+  TuyaWaterQualityThresholds beginThresholds();
+
+  bool getHistoryStats(TuyaWaterQualityDataPoint dataPoint, TuyaWaterQualityWindow window, TuyaHistoryStats& stats) const;
+  bool setHistoryWindow(TuyaWaterQualityWindow window, uint32_t length);
+  const TuyaWaterQualityHistory* getHistory(TuyaWaterQualityDataPoint dataPoint) const;
+
+  void onReceiveSensor(void (*callback)(TuyaWaterQualitySensor& sensor, uint16_t fields));
+  void onReceiveSensor(void (*callback)(TuyaWaterQuality& device, TuyaWaterQualitySensor& sensor, uint16_t fields,
+    void* context), void* context);
+  bool setNotifyFilter(TuyaWaterQualityDataPoint dataPoint, const TuyaNotifyFilter& filter);
+  bool clearNotifyFilter(TuyaWaterQualityDataPoint dataPoint);
+
+  void onAlarm(void (*callback)(TuyaWaterQuality& device, const TuyaAlarmEvent& event, void* context),
+    void* context = nullptr);
+  bool setAlarmConfig(TuyaWaterQualityAlarm alarm, const TuyaAlarmConfig& config);
+  const TuyaAlarm* getAlarm(TuyaWaterQualityAlarm alarm) const;
 
 private:
-  TuyaWaterQualitySensor _sensorData;
-  void (*_onReceiveSensor)(TuyaWaterQualitySensor& sensor);
+  friend class TuyaWaterQualityThresholds;
 
-  bool decodeReportStatusAsync(TuyaFrame& frame) override;
-  uint32_t decodeSensorRawValue(uint8_t* data);
-  bool setThreshold(TuyaWaterQualityDataPoint datapoint, int32_t value);
-  bool generateSensorData(uint8_t(&buffer)[8], TuyaWaterQualityDataPoint dataPoint, int32_t value);
+  TuyaWaterQualitySensor _sensorData;
+  uint16_t _reportedFields;
+  TuyaWaterQualityHistory _temperatureHistory;
+  TuyaWaterQualityHistory _phHistory;
+  TuyaWaterQualityHistory _tdsHistory;
+  TuyaChangeFilter _filters[waterQualityDataPoints.size()];
+  TuyaThresholdWrite _writes[waterQualityDataPoints.size()];
+  int8_t _filterTimer;
+  TuyaAlarm _alarms[TUYA_WATER_QUALITY_ALARMS];
+  void (*_onAlarm)(TuyaWaterQuality& device, const TuyaAlarmEvent& event, void* context);
+  void* _onAlarmContext;
+  void (*_onReceiveSensor)(TuyaWaterQualitySensor& sensor, uint16_t fields);
+  void (*_onReceiveSensorDevice)(TuyaWaterQuality& device, TuyaWaterQualitySensor& sensor, uint16_t fields,
+    void* context);
+  void* _onReceiveSensorContext;
+
+  bool decodeReportStatusAsync(const TuyaFrameView& frame) override;
+  uint8_t dataPointCount() const override;
+  bool saveState(TuyaSnapshotWriter& writer) const override;
+  bool restoreState(TuyaSnapshotReader& reader) override;
+  bool isReported(uint8_t dataPoint, int32_t value) const;
+  bool isPending(uint8_t dataPoint, int32_t value, uint32_t now) const;
+  void settleWrites(uint16_t fields);
+  bool thresholdsChanged(const TuyaWaterQualitySensor& previous, uint16_t fields) const;
+  void recordHistory(uint16_t fields);
+  TuyaChangeFilter* filter(uint8_t dataPoint);
+  uint16_t filterFields(uint16_t fields, uint32_t now);
+  void notifySensor(uint16_t fields);
+  void evaluateAlarms(uint16_t fields, uint32_t now);
+
+  static void filterTask(void* context);
+  bool sendThresholds(const uint8_t* dataPoints, const int32_t* values, uint8_t count);
+
+  template <TuyaWaterQualityDataPoint DataPoint>
+  bool setThreshold(int32_t value) {
+    static_assert(waterQualityDataPoints.find(DataPoint) != nullptr, "data point is not in the table");
+    static_assert(waterQualityDataPoints.find(DataPoint)->writable, "data point is read-only");
+    static_assert(waterQualityDataPoints.find(DataPoint)->type == DT_VALUE, "data point is not a value");
+    TuyaDpValueFrame<DataPoint> frame = TuyaDpValueFrame<DataPoint>::make(value);
+    return sendFrame(frame.bytes, frame.size);
+  }
 };
 
 #endif // TUYA_WATER_QUALITY_H
\ No newline at end of file
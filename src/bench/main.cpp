@@ -0,0 +1,304 @@
+#include <Arduino.h>
+#include <MemoryStream.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "tuya_water_quality.h"
+#include "tuya_spsc_ring.h"
+
+#define BENCH_TARGET_BYTES (64UL * 1024 * 1024)
+#define BENCH_MIN_FRAMES 20000UL
+
+// Function
+std::vector<uint8_t> buildStatusFrame(uint16_t payloadLength);
+size_t framesFor(uint16_t payloadLength);
+void report(const char* name, uint16_t payloadLength, size_t frames, double seconds);
+void benchParse(uint16_t payloadLength);
+void benchChecksum(uint16_t payloadLength);
+void benchResync(uint16_t payloadLength);
+void benchDecode(uint16_t payloadLength);
+void benchEndToEnd(uint16_t payloadLength);
+template <uint16_t Length>
+void benchGenerate();
+void benchDpValueFrame();
+void benchSpscRing();
+void benchProductInfo();
+void onSensor(TuyaWaterQualitySensor& sensor, uint16_t fields);
+
+typedef std::chrono::steady_clock Clock;
+
+// Exposes the protected decoder so the benchmark measures the shipped code
+class ProductInfoDecoder : public Tuya {
+public:
+  using Tuya::decodeProductInfo;
+};
+
+static const uint16_t payloadLengths[] = { 0, 8, 64, 256, 1024 };
+static const uint8_t dataPoints[] = {
+  DP_TEMPERATURE, DP_HIGH_TEMPERATURE_THRESHOLD, DP_LOW_TEMPERATURE_THRESHOLD,
+  DP_PH, DP_HIGH_PH_THRESHOLD, DP_LOW_PH_THRESHOLD,
+  DP_TDS, DP_HIGH_TDS_THRESHOLD, DP_LOW_TDS_THRESHOLD,
+};
+
+volatile uint32_t sink = 0;
+
+int main() {
+  printf("%-16s %8s %14s %10s\n", "benchmark", "payload", "frames/s", "ns/frame");
+
+  for (uint16_t length : payloadLengths) {
+    benchParse(length);
+  }
+  for (uint16_t length : payloadLengths) {
+    benchChecksum(length);
+  }
+  for (uint16_t length : payloadLengths) {
+    benchResync(length);
+  }
+  for (uint16_t length : payloadLengths) {
+    benchDecode(length);
+  }
+  for (uint16_t length : payloadLengths) {
+    benchEndToEnd(length);
+  }
+
+  benchGenerate<0>();
+  benchGenerate<8>();
+  benchGenerate<64>();
+  benchGenerate<256>();
+  benchGenerate<1024>();
+  benchDpValueFrame();
+  benchSpscRing();
+  benchProductInfo();
+
+  return 0;
+}
+
+// REPORT_STATUS_ASYNC frame filled with DT_VALUE TLVs of the water quality DPs
+std::vector<uint8_t> buildStatusFrame(uint16_t payloadLength) {
+  std::vector<uint8_t> frame = { 0x55, 0xAA, MCU, REPORT_STATUS_ASYNC, (uint8_t)(payloadLength >> 8), (uint8_t)payloadLength };
+  for (uint16_t i = 0; i < payloadLength / 8; i++) {
+    uint32_t value = 100 + i;
+    uint8_t tlv[8] = {
+      dataPoints[i % sizeof(dataPoints)], DT_VALUE, 0x00, 0x04,
+      (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value,
+    };
+    frame.insert(frame.end(), tlv, tlv + sizeof(tlv));
+  }
+  frame.push_back(tuyaChecksum(frame.data(), frame.size()));
+  return frame;
+}
+
+size_t framesFor(uint16_t payloadLength) {
+  size_t frames = BENCH_TARGET_BYTES / (payloadLength + TUYA_HEADER_SIZE + 1);
+  return frames < BENCH_MIN_FRAMES ? BENCH_MIN_FRAMES : frames;
+}
+
+void report(const char* name, uint16_t payloadLength, size_t frames, double seconds) {
+  printf("%-16s %8u %14.0f %10.1f\n", name, payloadLength, frames / seconds, seconds * 1e9 / frames);
+}
+
+void benchParse(uint16_t payloadLength) {
+  std::vector<uint8_t> frame = buildStatusFrame(payloadLength);
+  size_t frames = framesFor(payloadLength);
+  TuyaFrameParser parser;
+  size_t parsed = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    for (uint8_t byte : frame) {
+      if (parser.push(byte) == ERROR_NONE) {
+        parsed++;
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  sink += parsed;
+  report("parse", payloadLength, frames, seconds);
+}
+
+void benchChecksum(uint16_t payloadLength) {
+  std::vector<uint8_t> frame = buildStatusFrame(payloadLength);
+  size_t frames = framesFor(payloadLength);
+  size_t valid = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    frame[TUYA_HEADER_SIZE - 1] ^= (n & 1);
+    valid += tuyaChecksum(frame.data(), frame.size() - 1) == frame.back();
+    frame[TUYA_HEADER_SIZE - 1] ^= (n & 1);
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  sink += valid;
+  report("checksum", payloadLength, frames, seconds);
+}
+
+void benchResync(uint16_t payloadLength) {
+  std::vector<uint8_t> frame = buildStatusFrame(payloadLength);
+  frame.back() ^= 0xFF;
+  size_t frames = framesFor(payloadLength);
+  TuyaFrameParser parser;
+  size_t errors = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    for (uint8_t byte : frame) {
+      TuyaErrorTransmission result = parser.push(byte);
+      while (result != ERROR_NO_DATA) {
+        errors += result == ERROR_CHECKSUM;
+        result = parser.poll();
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  sink += errors;
+  report("resync", payloadLength, frames, seconds);
+}
+
+void benchDecode(uint16_t payloadLength) {
+  std::vector<uint8_t> frame = buildStatusFrame(payloadLength);
+  size_t frames = framesFor(payloadLength);
+  TuyaWaterQualitySensor sensor = {};
+  uint16_t fields = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    TuyaDataPoint dataPoint;
+    TuyaDataPointReader reader(frame.data() + TUYA_HEADER_SIZE, payloadLength);
+    while (reader.next(dataPoint)) {
+      fields |= waterQualityDataPoints.decode(sensor, dataPoint);
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  sink += fields + sensor.tds.value;
+  report("decode", payloadLength, frames, seconds);
+}
+
+void benchEndToEnd(uint16_t payloadLength) {
+  std::vector<uint8_t> frame = buildStatusFrame(payloadLength);
+  size_t frames = framesFor(payloadLength) / 4;
+  MemoryStream stream;
+  TuyaWaterQuality waterQuality;
+  waterQuality.begin(&stream);
+  waterQuality.onReceiveSensor(onSensor);
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    stream.feed(frame.data(), frame.size());
+    waterQuality.loop();
+    if (stream.output().size() > 4096) {
+      stream.clearOutput();
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  report("loop", payloadLength, frames, seconds);
+}
+
+template <uint16_t Length>
+void benchGenerate() {
+  static constexpr TuyaStaticFrame<MODULE, SEND_COMMAND, Length> prototype;
+  size_t frames = framesFor(Length);
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    TuyaStaticFrame<MODULE, SEND_COMMAND, Length> frame = prototype;
+    for (uint16_t i = 0; i < Length; i++) {
+      frame.set(i, n + i);
+    }
+    sink += frame.checksum();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  report("generate", Length, frames, seconds);
+}
+
+void benchDpValueFrame() {
+  size_t frames = framesFor(8);
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    TuyaDpValueFrame<DP_HIGH_TDS_THRESHOLD> frame = TuyaDpValueFrame<DP_HIGH_TDS_THRESHOLD>::make(n);
+    sink += frame.checksum();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  report("dp-value-frame", 8, frames, seconds);
+}
+
+// Producer thread streams uneven chunks while the consumer drains the ring.
+// Measures throughput only, test_spsc_ring checks order and loss. Reported
+// per 1 KB block.
+void benchSpscRing() {
+  static TuyaSpscRing<2048> ring;
+  const size_t total = BENCH_TARGET_BYTES;
+
+  Clock::time_point start = Clock::now();
+  std::thread producer([total]() {
+    uint8_t chunk[97] = {};
+    size_t sent = 0;
+    while (sent < total) {
+      size_t length = 1 + sent % sizeof(chunk);
+      if (length > total - sent) {
+        length = total - sent;
+      }
+      size_t offset = 0;
+      while (offset < length) {
+        size_t written = ring.write(chunk + offset, length - offset);
+        if (written == 0) {
+          std::this_thread::yield();
+        }
+        offset += written;
+      }
+      sent += length;
+    }
+  });
+
+  uint8_t buffer[64];
+  size_t received = 0;
+  while (received < total) {
+    size_t count = ring.read(buffer, sizeof(buffer));
+    if (count == 0) {
+      std::this_thread::yield();
+    }
+    sink += count > 0 ? buffer[count - 1] : 0;
+    received += count;
+  }
+  producer.join();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  report("spsc-ring", 1024, total / 1024, seconds);
+}
+
+// Runs the shipped decodeProductInfo() on a product info payload
+void benchProductInfo() {
+  static const char payload[] = "{\"product_id\":\"ymf4oruhdbfgzq6v\",\"version\":\"1.0.0\",\"operation_mode\":0}";
+  size_t frames = framesFor(sizeof(payload) - 1);
+  ProductInfoDecoder decoder;
+  TuyaFrameView frame = {
+    .version = MCU,
+    .command = QUERY_PRODUCT_INFO,
+    .length = sizeof(payload) - 1,
+    .data = reinterpret_cast<const uint8_t*>(payload),
+    .checksum = 0,
+    .timestamp = 0,
+  };
+  size_t decoded = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t n = 0; n < frames; n++) {
+    decoded += decoder.decodeProductInfo(frame);
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  sink += decoded + decoder.getProductInformation().productId[0];
+  report("product-info", sizeof(payload) - 1, frames, seconds);
+}
+
+void onSensor(TuyaWaterQualitySensor& sensor, uint16_t fields) {
+  sink += fields;
+}
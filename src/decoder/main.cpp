@@ -0,0 +1,273 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "tuya.h"
+#include "tuya_mapped_file.h"
+#include "tuya_scanner.h"
+
+// Structs for the offline decoder
+struct FrameRef {
+  uint64_t offset;
+  uint16_t size;
+};
+
+struct DpColumn {
+  uint8_t type;
+  std::vector<uint64_t> offsets;
+  std::vector<int32_t> values;
+};
+
+struct DecodeSlice {
+  std::vector<DpColumn> columns;
+  uint64_t commands[256];
+  uint64_t skipped;
+};
+
+// Function
+void usage(const char* program);
+void findFrames(const uint8_t* data, size_t size, size_t begin, size_t end, std::vector<FrameRef>* frames);
+void mergeFrames(const uint8_t* data, size_t size, std::vector<std::vector<FrameRef>>& chunks, std::vector<FrameRef>& frames);
+void decodeFrames(const uint8_t* data, const FrameRef* frames, size_t count, DecodeSlice* slice);
+bool writeColumns(const char* directory, std::vector<DecodeSlice>& slices);
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char** argv) {
+  const char* input = nullptr;
+  const char* output = nullptr;
+  unsigned threads = std::thread::hardware_concurrency();
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = strtoul(argv[++i], nullptr, 10);
+    } else if (input == nullptr) {
+      input = argv[i];
+    } else if (output == nullptr) {
+      output = argv[i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (input == nullptr || output == nullptr) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+
+  TuyaMappedFile file;
+  if (!file.open(input)) {
+    fprintf(stderr, "Cannot map %s\n", input);
+    return 1;
+  }
+
+  const uint8_t* data = file.data();
+  size_t size = file.size();
+  Clock::time_point start = Clock::now();
+
+  // Find frames in every chunk independently, then stitch the chunk borders
+  std::vector<std::vector<FrameRef>> chunks(threads);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < threads; i++) {
+    size_t begin = size / threads * i;
+    size_t end = i + 1 == threads ? size : size / threads * (i + 1);
+    workers.emplace_back(findFrames, data, size, begin, end, &chunks[i]);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  std::vector<FrameRef> frames;
+  mergeFrames(data, size, chunks, frames);
+  chunks.clear();
+
+  // Decode DPs on all cores, each slice keeps its own columns in frame order
+  std::vector<DecodeSlice> slices(threads);
+  size_t perSlice = (frames.size() + threads - 1) / threads;
+  for (unsigned i = 0; i < threads; i++) {
+    size_t first = std::min(frames.size(), perSlice * i);
+    size_t count = std::min(frames.size() - first, perSlice);
+    workers.emplace_back(decodeFrames, data, frames.data() + first, count, &slices[i]);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  if (!writeColumns(output, slices)) {
+    fprintf(stderr, "Cannot write columns to %s\n", output);
+    return 1;
+  }
+
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  uint64_t commands[256] = {};
+  uint64_t skipped = 0;
+  for (DecodeSlice& slice : slices) {
+    for (uint16_t i = 0; i < 256; i++) {
+      commands[i] += slice.commands[i];
+    }
+    skipped += slice.skipped;
+  }
+
+  printf("input:     %zu bytes\n", size);
+  printf("frames:    %zu\n", frames.size());
+  for (uint16_t i = 0; i < 256; i++) {
+    if (commands[i] > 0) {
+      printf("  command 0x%02X: %llu\n", i, (unsigned long long)commands[i]);
+    }
+  }
+  printf("skipped:   %llu DPs with raw or string type\n", (unsigned long long)skipped);
+  printf("elapsed:   %.3f s on %u threads (%.1f MB/s)\n", seconds, threads, size / seconds / 1e6);
+  return 0;
+}
+
+void usage(const char* program) {
+  fprintf(stderr, "Usage: %s <uart dump> <output directory> [--threads N]\n", program);
+}
+
+// Collects every frame that starts inside [begin, end). The last frame may
+// extend past end.
+void findFrames(const uint8_t* data, size_t size, size_t begin, size_t end, std::vector<FrameRef>* frames) {
+  size_t offset = begin;
+  uint16_t frameSize;
+  while ((offset = tuyaFindFrame(data, size, offset, frameSize)) < end) {
+    frames->push_back({ offset, frameSize });
+    offset += frameSize;
+  }
+}
+
+// A chunk scan that starts mid-frame can lock onto a false header. Where the
+// previous chunk's last frame overlaps, rescan sequentially until the scan
+// lands on a frame the chunk also found; from there both scans agree.
+void mergeFrames(const uint8_t* data, size_t size, std::vector<std::vector<FrameRef>>& chunks, std::vector<FrameRef>& frames) {
+  uint64_t position = 0;
+  for (std::vector<FrameRef>& chunk : chunks) {
+    size_t index = 0;
+    while (index < chunk.size() && chunk[index].offset < position) {
+      uint16_t frameSize;
+      size_t offset = tuyaFindFrame(data, size, position, frameSize);
+      if (offset >= size) {
+        index = chunk.size();
+        break;
+      }
+
+      std::vector<FrameRef>::iterator match = std::lower_bound(chunk.begin(), chunk.end(), offset,
+        [](const FrameRef& frame, uint64_t value) { return frame.offset < value; });
+      if (match != chunk.end() && match->offset == offset) {
+        index = match - chunk.begin();
+        break;
+      }
+
+      frames.push_back({ offset, frameSize });
+      position = offset + frameSize;
+      while (index < chunk.size() && chunk[index].offset < position) {
+        index++;
+      }
+    }
+
+    for (; index < chunk.size(); index++) {
+      frames.push_back(chunk[index]);
+      position = chunk[index].offset + chunk[index].size;
+    }
+  }
+}
+
+void decodeFrames(const uint8_t* data, const FrameRef* frames, size_t count, DecodeSlice* slice) {
+  slice->columns.resize(256);
+  memset(slice->commands, 0, sizeof(slice->commands));
+  slice->skipped = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* frame = data + frames[i].offset;
+    uint8_t command = frame[3];
+    slice->commands[command]++;
+    if (command != REPORT_STATUS_ASYNC && command != REPORT_STATUS_SYNC) {
+      continue;
+    }
+
+    TuyaDataPoint dataPoint;
+    TuyaDataPointReader reader(frame + TUYA_HEADER_SIZE, frames[i].size - TUYA_HEADER_SIZE - 1);
+    while (reader.next(dataPoint)) {
+      if (dataPoint.type == DT_RAW || dataPoint.type == DT_STRING || dataPoint.length == 0 || dataPoint.length > 4) {
+        slice->skipped++;
+        continue;
+      }
+
+      uint32_t raw = 0;
+      for (uint16_t j = 0; j < dataPoint.length; j++) {
+        raw = (raw << 8) | dataPoint.value[j];
+      }
+
+      DpColumn& column = slice->columns[dataPoint.id];
+      column.type = dataPoint.type;
+      column.offsets.push_back(frames[i].offset);
+      column.values.push_back(static_cast<int32_t>(raw));
+    }
+  }
+}
+
+// One pair of little-endian column files per DP, plus an index
+bool writeColumns(const char* directory, std::vector<DecodeSlice>& slices) {
+  mkdir(directory, 0755);
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/index.csv", directory);
+  FILE* index = fopen(path, "w");
+  if (index == nullptr) {
+    return false;
+  }
+  fprintf(index, "dp,type,samples,offsets,values\n");
+
+  for (uint16_t id = 0; id < 256; id++) {
+    size_t samples = 0;
+    uint8_t type = 0;
+    for (DecodeSlice& slice : slices) {
+      if (!slice.columns.empty() && !slice.columns[id].values.empty()) {
+        samples += slice.columns[id].values.size();
+        type = slice.columns[id].type;
+      }
+    }
+    if (samples == 0) {
+      continue;
+    }
+
+    char offsetsName[32];
+    char valuesName[32];
+    snprintf(offsetsName, sizeof(offsetsName), "dp_%u.offset.u64", id);
+    snprintf(valuesName, sizeof(valuesName), "dp_%u.value.i32", id);
+
+    snprintf(path, sizeof(path), "%s/%s", directory, offsetsName);
+    FILE* offsets = fopen(path, "wb");
+    snprintf(path, sizeof(path), "%s/%s", directory, valuesName);
+    FILE* values = fopen(path, "wb");
+    if (offsets == nullptr || values == nullptr) {
+      fclose(index);
+      return false;
+    }
+
+    for (DecodeSlice& slice : slices) {
+      if (slice.columns.empty()) {
+        continue;
+      }
+      DpColumn& column = slice.columns[id];
+      fwrite(column.offsets.data(), sizeof(uint64_t), column.offsets.size(), offsets);
+      fwrite(column.values.data(), sizeof(int32_t), column.values.size(), values);
+    }
+    fclose(offsets);
+    fclose(values);
+
+    fprintf(index, "%u,%u,%zu,%s,%s\n", id, type, samples, offsetsName, valuesName);
+  }
+
+  fclose(index);
+  return true;
+}
@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+#include "tuya_water_quality.h"
+#include "tuya_bus.h"
+#include "tuya_event_loop.h"
+#include "tuya_fd_stream.h"
+#include "tuya_file_store.h"
+#include "tuya_mcu_simulator.h"
+
+// Function
+void usage(const char* program);
+void logSensor(uint8_t device, TuyaWaterQualitySensor& sensor, uint16_t fields, void* context);
+void logAlarm(uint8_t device, const TuyaAlarmEvent& event, void* context);
+
+int main(int argc, char** argv) {
+  std::vector<const char*> ports;
+  uint32_t baud = 9600;
+  unsigned long simulate = 0;
+  unsigned long duration = 0;
+  const char* stateDirectory = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) {
+      baud = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--simulate") == 0 && i + 1 < argc) {
+      simulate = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+      duration = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--state") == 0 && i + 1 < argc) {
+      stateDirectory = argv[++i];
+    } else if (argv[i][0] != '-') {
+      ports.push_back(argv[i]);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (ports.empty() && simulate == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (ports.size() + simulate > TUYA_EVENT_LOOP_DEVICES || ports.size() + simulate > TUYA_BUS_DEVICES) {
+    fprintf(stderr, "At most %d devices\n", TUYA_EVENT_LOOP_DEVICES < TUYA_BUS_DEVICES ? TUYA_EVENT_LOOP_DEVICES : TUYA_BUS_DEVICES);
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<TuyaMcuSimulator>> simulators;
+  std::vector<std::unique_ptr<TuyaFdStream>> streams;
+  std::vector<std::unique_ptr<TuyaFileStore>> stores;
+  // Too large for the stack with its histories
+  static TuyaBus bus;
+  TuyaEventLoop loop;
+
+  for (unsigned long i = 0; i < simulate; i++) {
+    simulators.emplace_back(new TuyaMcuSimulator());
+    if (!simulators.back()->open() || !simulators.back()->start(1000)) {
+      fprintf(stderr, "Cannot open a pty for the simulated MCU\n");
+      return 1;
+    }
+    streams.emplace_back(new TuyaFdStream());
+    streams.back()->attach(simulators.back()->slaveFd());
+    printf("simulated MCU on %s\n", simulators.back()->slaveName());
+  }
+
+  for (const char* port : ports) {
+    streams.emplace_back(new TuyaFdStream());
+    if (!streams.back()->open(port, baud)) {
+      fprintf(stderr, "Cannot open %s at %u baud\n", port, baud);
+      return 1;
+    }
+  }
+
+  bus.onReceiveSensor(logSensor);
+  bus.onAlarm(logAlarm);
+  for (std::unique_ptr<TuyaFdStream>& stream : streams) {
+    TuyaFileStore* store = nullptr;
+    if (stateDirectory != nullptr) {
+      std::string path = std::string(stateDirectory) + "/device" + std::to_string(bus.size()) + ".state";
+      stores.emplace_back(new TuyaFileStore(path));
+      store = stores.back().get();
+    }
+    TuyaWaterQuality* device = bus.device(bus.add(stream.get(), store));
+    if (device == nullptr || !loop.add(*stream, *device)) {
+      fprintf(stderr, "Cannot add device %u\n", bus.size());
+      return 1;
+    }
+  }
+
+  uint32_t start = millis();
+  while (duration == 0 || millis() - start < duration * 1000) {
+    uint32_t ready;
+    if (loop.wait(1000, ready) < 0) {
+      perror("epoll_wait");
+      return 1;
+    }
+    bus.loop(ready);
+  }
+
+  for (uint8_t i = 0; i < bus.size(); i++) {
+    TuyaWaterQuality& device = *bus.device(i);
+    if (stateDirectory != nullptr) {
+      device.saveSnapshot();
+    }
+    const TuyaStats& stats = device.getStats();
+    uint32_t frames = 0;
+    for (uint8_t command = 0; command < TUYA_STATS_COMMANDS; command++) {
+      frames += stats.rxFrames[command];
+    }
+    printf("device %u: initialized %d, ready %d after %u ms, %u frames in, %u bytes in, %u checksum errors, %u loops\n",
+      i, device.isInitialized(), device.isReady(), stats.timeToReady, frames, stats.bytesIn,
+      stats.checksumErrors, stats.loops);
+  }
+  for (std::unique_ptr<TuyaMcuSimulator>& simulator : simulators) {
+    simulator->stop();
+  }
+  return 0;
+}
+
+void usage(const char* program) {
+  fprintf(stderr, "Usage: %s [<tty>...] [--baud N] [--simulate N] [--duration S] [--state DIR]\n", program);
+}
+
+void logSensor(uint8_t device, TuyaWaterQualitySensor& sensor, uint16_t fields, void* context) {
+  printf("%8u ms  device %u  temperature %.1f  pH %.2f  TDS %d\n", (unsigned)millis(), device,
+    tuyaFixedToFloat(sensor.temperature.value, sensor.temperature.decimals),
+    tuyaFixedToFloat(sensor.ph.value, sensor.ph.decimals), sensor.tds.value);
+}
+
+void logAlarm(uint8_t device, const TuyaAlarmEvent& event, void* context) {
+  static const char* names[TUYA_WATER_QUALITY_ALARMS] = {
+    "temperature high", "temperature low", "pH high", "pH low", "TDS high", "TDS low",
+  };
+  if (event.edge == ALARM_RAISED) {
+    printf("%8u ms  device %u  %s raised: %d past %d\n", (unsigned)millis(), device, names[event.alarm],
+      event.value, event.threshold);
+  } else {
+    printf("%8u ms  device %u  %s cleared after %u ms\n", (unsigned)millis(), device, names[event.alarm],
+      event.duration);
+  }
+}
@@ -1,12 +1,21 @@
 #include <Arduino.h>
 #include <HardwareSerial.h>
 #include "tuya_water_quality.h"
+#include "tuya_uart_reader.h"
+#include "tuya_nvs_store.h"
 
 #define DEBUG           true
+#define CAPTURE         false
+#define UART_READER     false
+#define PASSIVE         false
+#define PERSIST         false
 #define UART_RX_PIN     16
 #define UART_TX_PIN     17
+// Passive mode only: RX tapped onto the module's TX line
+#define UART_MODULE_PIN 4
 
-#if DEBUG
+// Capture output shares Serial, so it disables the debug text
+#if DEBUG && !CAPTURE
 #define D_begin(...)    Serial.begin(__VA_ARGS__)
 #define D_print(...)    Serial.print(__VA_ARGS__)
 #define D_write(...)    Serial.write(__VA_ARGS__)
@@ -20,11 +29,18 @@
 
 // Function 
 void resetDevice();
-void logSensor(TuyaWaterQualitySensor& sensor);
+void logSensor(TuyaWaterQualitySensor& sensor, uint16_t fields);
+void logAlarm(TuyaWaterQuality& device, const TuyaAlarmEvent& event, void* context);
+void syncDevice(void* context);
+void printRoundTrips(void* context);
 
 // Hardware serial and water quality sensor
 HardwareSerial TuyaSniffer(2);
+HardwareSerial TuyaModuleLine(1);
 TuyaWaterQuality waterQuality;
+TuyaCaptureWriter capture(Serial);
+TuyaUartReader uartReader;
+TuyaNvsStore stateStore;
 
 
 
@@ -32,13 +48,44 @@ void setup() {
   D_begin(115200);
   TuyaSniffer.begin(9600, SERIAL_8N1, UART_RX_PIN, UART_TX_PIN);
 
-  waterQuality.begin(&TuyaSniffer);
-  waterQuality.debug(Serial, DEBUG);
+  // Warm-start from the last snapshot after a watchdog reset
+  if (PERSIST) {
+    waterQuality.persist(&stateStore);
+  }
+
+  // Reader task on core 0 keeps draining the UART while loop() runs on core 1
+  if (PASSIVE) {
+    TuyaModuleLine.begin(9600, SERIAL_8N1, UART_MODULE_PIN, -1);
+    waterQuality.beginPassive(&TuyaSniffer, &TuyaModuleLine);
+  } else if (UART_READER && uartReader.begin(TuyaSniffer, 0)) {
+    waterQuality.begin(&uartReader);
+  } else {
+    waterQuality.begin(&TuyaSniffer);
+  }
+  waterQuality.debug(Serial, DEBUG && !CAPTURE);
+  if (CAPTURE) {
+    Serial.begin(115200);
+    capture.begin();
+    waterQuality.capture(&capture);
+  }
   waterQuality.onResetWiFiPairMode(resetDevice);
   waterQuality.onReceiveSensor(logSensor);
+  waterQuality.onAlarm(logAlarm);
+  // TDS readings jitter by a few ppm around the threshold
+  waterQuality.setAlarmConfig(ALARM_TDS_HIGH, { 10, 3 });
+  waterQuality.setAlarmConfig(ALARM_TDS_LOW, { 10, 3 });
+  if (PASSIVE) {
+    waterQuality.every(60000, printRoundTrips);
+  } else {
+    waterQuality.every(5000, syncDevice);
+  }
 }
 
 void loop() {
+  waterQuality.loop();
+}
+
+void syncDevice(void* context) {
   if (waterQuality.isInitialized()) {
     TuyaProductInformation product = waterQuality.getProductInformation();
 
@@ -54,24 +101,42 @@ void loop() {
     float minTemperature = waterQuality.getMinTemperature();
     float temperature = waterQuality.getTemperature();
 
-    waterQuality.setMaxTDS(1000);
-    waterQuality.setMinTDS(500);
-
-    waterQuality.setMaxPH(7.0 * 100);
-    waterQuality.setMinPH(5.5 * 100);
-
-    waterQuality.setMaxTemperature(31.2 * 10);
-    waterQuality.setMinTemperature(20.5 * 10);
+    waterQuality.beginThresholds()
+      .setMaxTDS(1000)
+      .setMinTDS(500)
+      .setMaxPH(7.0 * 100)
+      .setMinPH(5.5 * 100)
+      .setMaxTemperature(31.2 * 10)
+      .setMinTemperature(20.5 * 10)
+      .commit();
 
     waterQuality.getNetworkStatus();
     waterQuality.setNetworkStatus(WIFI_NOT_CONNECTED);
   }
+}
 
-
-  waterQuality.loop();
+// Median and p99 bucket bounds in µs of every command that saw a response
+void printRoundTrips(void* context) {
+  const TuyaRoundTripStats& stats = waterQuality.getRoundTripStats();
+  for (uint8_t command = 0; command < TUYA_STATS_COMMANDS; command++) {
+    const TuyaHistogram& latency = stats.latency[command];
+    if (latency.count() == 0 && stats.unanswered[command] == 0) {
+      continue;
+    }
+    D_print("Command 0x");
+    D_print(command, HEX);
+    D_print(": ");
+    D_print(latency.count());
+    D_print(" replies, p50 <= ");
+    D_print(latency.percentile(50));
+    D_print(" us, p99 <= ");
+    D_print(latency.percentile(99));
+    D_print(" us, unanswered ");
+    D_println(stats.unanswered[command]);
+  }
 }
 
-void logSensor(TuyaWaterQualitySensor& sensor) {
+void logSensor(TuyaWaterQualitySensor& sensor, uint16_t fields) {
   D_print("TDS: ");
   D_print(sensor.tds.value);
   D_print(" High: ");
@@ -80,22 +145,37 @@ void logSensor(TuyaWaterQualitySensor& sensor) {
   D_println(sensor.tds.MinThreshold);
 
   D_print("pH: ");
-  D_print(sensor.ph.value);
+  D_print(tuyaFixedToFloat(sensor.ph.value, sensor.ph.decimals));
   D_print(" High: ");
-  D_print(sensor.ph.MaxThreshold);
+  D_print(tuyaFixedToFloat(sensor.ph.MaxThreshold, sensor.ph.decimals));
   D_print(" Low: ");
-  D_println(sensor.ph.MinThreshold);
+  D_println(tuyaFixedToFloat(sensor.ph.MinThreshold, sensor.ph.decimals));
 
   D_print("Temperature: ");
-  D_print(sensor.temperature.value);
+  D_print(tuyaFixedToFloat(sensor.temperature.value, sensor.temperature.decimals));
   D_print(" High: ");
-  D_print(sensor.temperature.MaxThreshold);
+  D_print(tuyaFixedToFloat(sensor.temperature.MaxThreshold, sensor.temperature.decimals));
   D_print(" Low: ");
-  D_println(sensor.temperature.MinThreshold);
+  D_println(tuyaFixedToFloat(sensor.temperature.MinThreshold, sensor.temperature.decimals));
 
   D_println();
 }
 
+void logAlarm(TuyaWaterQuality& device, const TuyaAlarmEvent& event, void* context) {
+  D_print("Alarm ");
+  D_print(event.alarm);
+  if (event.edge == ALARM_RAISED) {
+    D_print(" raised, value: ");
+    D_print(event.value);
+    D_print(" threshold: ");
+    D_println(event.threshold);
+  } else {
+    D_print(" cleared after ");
+    D_print(event.duration);
+    D_println(" ms");
+  }
+}
+
 void resetDevice() {
   ESP.restart();
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "tuya_water_quality.h"
+#include "tuya_capture_reader.h"
+
+// Function
+void usage(const char* program);
+void onSensor(TuyaWaterQualitySensor& sensor, uint16_t fields);
+
+typedef std::chrono::steady_clock Clock;
+
+uint64_t sensorUpdates = 0;
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  bool realtime = false;
+  unsigned long repeat = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--realtime") == 0) {
+      realtime = true;
+    } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = strtoul(argv[++i], nullptr, 10);
+    } else if (path == nullptr) {
+      path = argv[i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (path == nullptr || repeat == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  TuyaCaptureReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "Cannot open capture %s\n", path);
+    return 1;
+  }
+
+  // begin() is never called, so replies to replayed frames are not written
+  TuyaWaterQuality waterQuality;
+  waterQuality.onReceiveSensor(onSensor);
+
+  uint64_t rxFrames = 0;
+  uint64_t txFrames = 0;
+  uint64_t bytes = 0;
+  Clock::time_point start = Clock::now();
+  // History windows, change filters and alarm debounce read millis(), run
+  // them on capture time so a replay reproduces the original timing. Every
+  // pass continues where the previous one ended.
+  uint64_t clock = 0;
+
+  for (unsigned long pass = 0; pass < repeat; pass++) {
+    reader.rewind();
+    TuyaCaptureRecord record;
+    uint64_t firstTimestamp = 0;
+    uint64_t passClock = clock;
+    bool first = true;
+    Clock::time_point passStart = Clock::now();
+
+    while (reader.next(record)) {
+      if (first) {
+        firstTimestamp = record.timestamp;
+        first = false;
+      }
+
+      if (realtime) {
+        std::this_thread::sleep_until(passStart + std::chrono::microseconds(record.timestamp - firstTimestamp));
+      }
+      clock = passClock + (record.timestamp - firstTimestamp);
+      setNativeClock(clock);
+
+      bytes += record.length;
+      // Our own replies carry nothing to decode, they are only counted
+      if (record.direction == CAPTURE_TX) {
+        txFrames++;
+        continue;
+      }
+
+      rxFrames++;
+      waterQuality.feed(record.data, record.length);
+    }
+  }
+  releaseNativeClock();
+
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("rx frames:      %llu\n", (unsigned long long)rxFrames);
+  printf("tx frames:      %llu\n", (unsigned long long)txFrames);
+  printf("sensor updates: %llu\n", (unsigned long long)sensorUpdates);
+  printf("elapsed:        %.3f s\n", seconds);
+  if (seconds > 0) {
+    printf("throughput:     %.0f frames/s, %.1f MB/s\n", (rxFrames + txFrames) / seconds, bytes / seconds / 1e6);
+  }
+  return 0;
+}
+
+void usage(const char* program) {
+  fprintf(stderr, "Usage: %s <capture> [--realtime] [--repeat N]\n", program);
+}
+
+void onSensor(TuyaWaterQualitySensor& sensor, uint16_t fields) {
+  sensorUpdates++;
+}
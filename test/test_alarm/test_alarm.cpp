@@ -0,0 +1,91 @@
+#include <unity.h>
+#include <tuya_alarm.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_raises_after_debounce_samples_in_a_row() {
+  TuyaAlarm alarm;
+  alarm.configure({ 0, 3 });
+
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 100));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(2, 200));
+  TEST_ASSERT_EQUAL_INT(ALARM_RAISED, alarm.evaluate(3, 300));
+  TEST_ASSERT_TRUE(alarm.raised());
+  TEST_ASSERT_EQUAL_UINT32(300, alarm.raisedAt());
+  TEST_ASSERT_EQUAL_UINT32(1, alarm.raisedCount());
+  // Staying past the limit is no new edge
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(3, 400));
+}
+
+void test_clears_only_back_by_hysteresis() {
+  TuyaAlarm alarm;
+  alarm.configure({ 5, 1 });
+
+  TEST_ASSERT_EQUAL_INT(ALARM_RAISED, alarm.evaluate(1, 100));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(0, 200));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(-4, 300));
+  TEST_ASSERT_TRUE(alarm.raised());
+  TEST_ASSERT_EQUAL_INT(ALARM_CLEARED, alarm.evaluate(-5, 400));
+  TEST_ASSERT_FALSE(alarm.raised());
+  TEST_ASSERT_EQUAL_UINT32(400, alarm.clearedAt());
+}
+
+void test_non_crossing_sample_restarts_debounce() {
+  TuyaAlarm alarm;
+  alarm.configure({ 0, 3 });
+
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 100));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 200));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(0, 300));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 400));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 500));
+  TEST_ASSERT_FALSE(alarm.raised());
+  TEST_ASSERT_EQUAL_INT(ALARM_RAISED, alarm.evaluate(1, 600));
+}
+
+// A moved limit can break a streak but never adds a sample to it
+void test_recheck_never_extends_streak() {
+  TuyaAlarm alarm;
+  alarm.configure({ 0, 2 });
+
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 100));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.recheck(1, 200));
+  TEST_ASSERT_FALSE(alarm.raised());
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.recheck(-1, 300));
+  TEST_ASSERT_EQUAL_INT(ALARM_NONE, alarm.evaluate(1, 400));
+  TEST_ASSERT_EQUAL_INT(ALARM_RAISED, alarm.evaluate(1, 500));
+
+  alarm.reset();
+  alarm.configure({ 0, 1 });
+  TEST_ASSERT_EQUAL_INT(ALARM_RAISED, alarm.recheck(1, 600));
+}
+
+void test_duration_covers_running_and_last_episode() {
+  TuyaAlarm alarm;
+  alarm.configure({ 0, 1 });
+
+  TEST_ASSERT_EQUAL_UINT32(0, alarm.duration(50));
+  alarm.evaluate(1, 100);
+  TEST_ASSERT_EQUAL_UINT32(60, alarm.duration(160));
+  alarm.evaluate(-1, 250);
+  TEST_ASSERT_EQUAL_UINT32(150, alarm.duration(1000));
+
+  // millis() wrapping while raised
+  alarm.evaluate(1, UINT32_MAX - 9);
+  TEST_ASSERT_EQUAL_UINT32(20, alarm.duration(10));
+  TEST_ASSERT_EQUAL_UINT32(2, alarm.raisedCount());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_raises_after_debounce_samples_in_a_row);
+  RUN_TEST(test_clears_only_back_by_hysteresis);
+  RUN_TEST(test_non_crossing_sample_restarts_debounce);
+  RUN_TEST(test_recheck_never_extends_streak);
+  RUN_TEST(test_duration_covers_running_and_last_episode);
+  return UNITY_END();
+}
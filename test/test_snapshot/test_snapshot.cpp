@@ -0,0 +1,150 @@
+#include <unity.h>
+#include <vector>
+#include <MemoryStream.h>
+#include <tuya.h>
+#include <tuya_snapshot.h>
+
+// Store backed by a vector the tests can corrupt between save and load
+class MemoryStore : public TuyaStateStore {
+public:
+  std::vector<uint8_t> blob;
+
+  size_t load(uint8_t* data, size_t size) override {
+    if (blob.size() > size) {
+      return 0;
+    }
+    memcpy(data, blob.data(), blob.size());
+    return blob.size();
+  }
+
+  bool save(const uint8_t* data, size_t length) override {
+    blob.assign(data, data + length);
+    return true;
+  }
+};
+
+static MemoryStore store;
+
+static void feedFrame(Tuya& device, MemoryStream& stream, uint8_t command, const char* data) {
+  uint8_t length = strlen(data);
+  uint8_t frame[TUYA_FRAME_BUFFER_SIZE] = { 0x55, 0xAA, 0x03, command, 0x00, length };
+  memcpy(frame + TUYA_HEADER_SIZE, data, length);
+  frame[TUYA_HEADER_SIZE + length] = tuyaChecksum(frame, TUYA_HEADER_SIZE + length);
+  stream.feed(frame, TUYA_HEADER_SIZE + length + 1);
+  device.loop();
+}
+
+// Runs a device through the handshake and stores its snapshot
+static void saveInitializedDevice() {
+  MemoryStream stream;
+  Tuya device;
+  device.persist(&store);
+  device.begin(&stream);
+  feedFrame(device, stream, HEARTBEATS, "\x01");
+  feedFrame(device, stream, QUERY_PRODUCT_INFO, "{\"p\":\"ymf4oruhdbfgzq6v\",\"v\":\"1.0.0\",\"m\":0}");
+  feedFrame(device, stream, QUERY_WORKING_MODE, "");
+  TEST_ASSERT_TRUE(device.isInitialized());
+  TEST_ASSERT_TRUE(device.saveSnapshot());
+}
+
+static bool warmStarts() {
+  MemoryStream stream;
+  Tuya device;
+  device.persist(&store);
+  device.begin(&stream);
+  return device.isWarm() && device.isInitialized();
+}
+
+static void updateCrc() {
+  uint16_t crc = tuyaCrc16(store.blob.data(), store.blob.size() - 2);
+  store.blob[store.blob.size() - 2] = crc & 0xFF;
+  store.blob[store.blob.size() - 1] = crc >> 8;
+}
+
+void setUp() {
+  store.blob.clear();
+  saveInitializedDevice();
+}
+
+void tearDown() {
+}
+
+// A field that does not fit is dropped whole, and nothing after it is written
+void test_writer_overflow() {
+  uint8_t buffer[5];
+  TuyaSnapshotWriter writer(buffer, sizeof(buffer));
+  writer.putU16(0x1234);
+  TEST_ASSERT_FALSE(writer.overflowed());
+  writer.putI32(-1);
+  writer.putU8(0x56);
+  TEST_ASSERT_TRUE(writer.overflowed());
+  TEST_ASSERT_EQUAL_UINT16(2, writer.length());
+  TEST_ASSERT_EQUAL_UINT8(0x34, buffer[0]);
+  TEST_ASSERT_EQUAL_UINT8(0x12, buffer[1]);
+}
+
+void test_reader_round_trip_and_overflow() {
+  uint8_t buffer[32];
+  TuyaSnapshotWriter writer(buffer, sizeof(buffer));
+  writer.putU8(7);
+  writer.putU16(0xBEEF);
+  writer.putI32(-123456);
+  writer.putString("1.0.0");
+
+  TuyaSnapshotReader reader(buffer, writer.length());
+  char version[8];
+  TEST_ASSERT_EQUAL_UINT8(7, reader.getU8());
+  TEST_ASSERT_EQUAL_UINT16(0xBEEF, reader.getU16());
+  TEST_ASSERT_EQUAL_INT(-123456, reader.getI32());
+  TEST_ASSERT_TRUE(reader.getString(version, sizeof(version)));
+  TEST_ASSERT_EQUAL_STRING("1.0.0", version);
+  TEST_ASSERT_EQUAL_UINT16(0, reader.remaining());
+  TEST_ASSERT_FALSE(reader.failed());
+
+  TEST_ASSERT_EQUAL_UINT16(0, reader.getU16());
+  TEST_ASSERT_TRUE(reader.failed());
+
+  // A string longer than the output fails instead of truncating
+  TuyaSnapshotReader shortReader(buffer, writer.length());
+  shortReader.getBytes(7);
+  TEST_ASSERT_FALSE(shortReader.getString(version, 4));
+  TEST_ASSERT_TRUE(shortReader.failed());
+}
+
+void test_restore_warm_starts() {
+  TEST_ASSERT_TRUE(warmStarts());
+}
+
+void test_restore_rejects_crc_mismatch() {
+  store.blob[TUYA_SNAPSHOT_HEADER_SIZE + 1] ^= 0x01;
+  TEST_ASSERT_FALSE(warmStarts());
+}
+
+void test_restore_rejects_length_mismatch() {
+  store.blob.pop_back();
+  TEST_ASSERT_FALSE(warmStarts());
+
+  // Payload length off by one under a valid CRC
+  store.blob.clear();
+  saveInitializedDevice();
+  store.blob[3]++;
+  updateCrc();
+  TEST_ASSERT_FALSE(warmStarts());
+}
+
+void test_restore_rejects_other_version() {
+  store.blob[2] = TUYA_SNAPSHOT_VERSION + 1;
+  updateCrc();
+  TEST_ASSERT_FALSE(warmStarts());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_writer_overflow);
+  RUN_TEST(test_reader_round_trip_and_overflow);
+  RUN_TEST(test_restore_warm_starts);
+  RUN_TEST(test_restore_rejects_crc_mismatch);
+  RUN_TEST(test_restore_rejects_length_mismatch);
+  RUN_TEST(test_restore_rejects_other_version);
+  return UNITY_END();
+}
@@ -0,0 +1,146 @@
+#include <unity.h>
+#include <thread>
+#include <tuya_spsc_ring.h>
+
+#define STRESS_BYTES (4UL << 20)
+
+// Not periodic in 256, so a lost or repeated block of bytes shows up
+static uint8_t patternAt(size_t index) {
+  return (index ^ (index >> 8) ^ (index >> 16)) & 0xFF;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Producer and consumer threads with odd chunk sizes, so the copies split at
+// the end of the buffer in every position over thousands of wraps
+void test_threads_keep_order_and_lose_nothing() {
+  static TuyaSpscRing<2048> ring;
+  const size_t total = STRESS_BYTES;
+
+  std::thread producer([total]() {
+    uint8_t chunk[97];
+    size_t sent = 0;
+    while (sent < total) {
+      size_t length = 1 + sent % sizeof(chunk);
+      if (length > total - sent) {
+        length = total - sent;
+      }
+      for (size_t i = 0; i < length; i++) {
+        chunk[i] = patternAt(sent + i);
+      }
+      size_t offset = 0;
+      while (offset < length) {
+        size_t written = ring.write(chunk + offset, length - offset);
+        if (written == 0) {
+          std::this_thread::yield();
+        }
+        offset += written;
+      }
+      sent += length;
+    }
+  });
+
+  uint8_t buffer[61];
+  size_t received = 0;
+  size_t mismatch = SIZE_MAX;
+  while (received < total) {
+    size_t count = ring.read(buffer, 1 + received % sizeof(buffer));
+    if (count == 0) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < count && mismatch == SIZE_MAX; i++) {
+      if (buffer[i] != patternAt(received + i)) {
+        mismatch = received + i;
+      }
+    }
+    received += count;
+    if (mismatch != SIZE_MAX) {
+      break;
+    }
+  }
+  // Drain so the producer can finish even after a failure
+  while (received < total) {
+    received += ring.read(buffer, sizeof(buffer));
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT64(SIZE_MAX, mismatch);
+  TEST_ASSERT_EQUAL_UINT64(total, received);
+  TEST_ASSERT_EQUAL_UINT64(0, ring.available());
+}
+
+// Byte-at-a-time reads against bulk writes, the peek()/read() path the UART
+// reader uses
+void test_threads_single_byte_reads() {
+  static TuyaSpscRing<64> ring;
+  const size_t total = STRESS_BYTES / 16;
+
+  std::thread producer([total]() {
+    uint8_t chunk[48];
+    size_t sent = 0;
+    while (sent < total) {
+      size_t length = total - sent < sizeof(chunk) ? total - sent : sizeof(chunk);
+      for (size_t i = 0; i < length; i++) {
+        chunk[i] = patternAt(sent + i);
+      }
+      size_t offset = 0;
+      while (offset < length) {
+        size_t written = ring.write(chunk + offset, length - offset);
+        if (written == 0) {
+          std::this_thread::yield();
+        }
+        offset += written;
+      }
+      sent += length;
+    }
+  });
+
+  size_t received = 0;
+  size_t mismatch = SIZE_MAX;
+  while (received < total) {
+    int peeked = ring.peek();
+    if (peeked < 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    int byte = ring.read();
+    if (mismatch == SIZE_MAX && (byte != peeked || byte != patternAt(received))) {
+      mismatch = received;
+    }
+    received++;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT64(SIZE_MAX, mismatch);
+  TEST_ASSERT_EQUAL_UINT64(total, received);
+}
+
+void test_full_ring_counts_dropped_bytes() {
+  TuyaSpscRing<16> ring;
+  uint8_t data[24];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = i;
+  }
+
+  TEST_ASSERT_EQUAL_UINT64(16, ring.write(data, sizeof(data)));
+  TEST_ASSERT_EQUAL_UINT64(8, ring.dropped());
+  TEST_ASSERT_EQUAL_UINT64(0, ring.write(data, 1));
+  TEST_ASSERT_EQUAL_UINT64(9, ring.dropped());
+
+  uint8_t out[16];
+  TEST_ASSERT_EQUAL_UINT64(16, ring.read(out, sizeof(out)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, out, sizeof(out));
+  TEST_ASSERT_EQUAL_INT(-1, ring.read());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_ring_counts_dropped_bytes);
+  RUN_TEST(test_threads_keep_order_and_lose_nothing);
+  RUN_TEST(test_threads_single_byte_reads);
+  return UNITY_END();
+}